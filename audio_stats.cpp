@@ -0,0 +1,104 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include "audio_stats.h"
+#include "util.h"
+
+static int getHistogramBucket(uint32_t value, uint32_t period, int bucketPercent) {
+	const int bucket = (uint64_t)value * 100 / (period * bucketPercent);
+	return MIN(bucket, AudioStats::kHistogramBuckets - 1);
+}
+
+void AudioTelemetry::reset() {
+	memset(_seconds, 0, sizeof(_seconds));
+	_prevTimestamp = 0;
+	_period = _lastDuration = _lastInterval = 0;
+	_totalCallbacks = _totalUnderruns = 0;
+}
+
+bool AudioTelemetry::addCallback(uint64_t timestamp, uint32_t duration, uint32_t period) {
+	const uint64_t num = timestamp / 1000000000;
+	Second *s = &_seconds[num % kSeconds];
+	if (s->num != num) {
+		memset(s, 0, sizeof(Second));
+		s->num = num;
+	}
+	_period = period;
+	_lastDuration = duration;
+	++_totalCallbacks;
+	++s->callbacks;
+	s->durationSum += duration;
+	s->maxDuration = MAX(s->maxDuration, duration);
+	++s->durationHistogram[getHistogramBucket(duration, period, AudioStats::kDurationBucketPercent)];
+	bool underrun = false;
+	if (_prevTimestamp != 0) {
+		_lastInterval = (timestamp - _prevTimestamp) / 1000;
+		s->maxInterval = MAX(s->maxInterval, _lastInterval);
+		++s->intervalHistogram[getHistogramBucket(_lastInterval, period, AudioStats::kIntervalBucketPercent)];
+		if (_lastInterval > period + period / 2) {
+			// called late, the device most likely played all the samples of the previous buffer
+			underrun = true;
+			++_totalUnderruns;
+			++s->underruns;
+		}
+	}
+	_prevTimestamp = timestamp;
+	return underrun;
+}
+
+void AudioTelemetry::getStats(uint64_t now, AudioStats *stats) const {
+	memset(stats, 0, sizeof(AudioStats));
+	stats->period = _period;
+	stats->lastDuration = _lastDuration;
+	stats->lastInterval = _lastInterval;
+	stats->totalCallbacks = _totalCallbacks;
+	stats->totalUnderruns = _totalUnderruns;
+	const uint64_t num = now / 1000000000;
+	uint64_t durationSum = 0;
+	for (int i = 0; i < kSeconds; ++i) {
+		const Second *s = &_seconds[i];
+		if (s->callbacks == 0 || s->num + kSeconds <= num) {
+			continue;
+		}
+		stats->callbacks += s->callbacks;
+		stats->underruns += s->underruns;
+		durationSum += s->durationSum;
+		stats->maxDuration = MAX(stats->maxDuration, s->maxDuration);
+		stats->maxInterval = MAX(stats->maxInterval, s->maxInterval);
+		for (int j = 0; j < AudioStats::kHistogramBuckets; ++j) {
+			stats->durationHistogram[j] += s->durationHistogram[j];
+			stats->intervalHistogram[j] += s->intervalHistogram[j];
+		}
+	}
+	if (stats->callbacks != 0) {
+		stats->avgDuration = durationSum / stats->callbacks;
+	}
+}
+
+static void formatHistogram(char *buf, int size, const uint32_t *histogram) {
+	int last = AudioStats::kHistogramBuckets - 1;
+	while (last > 0 && histogram[last] == 0) {
+		--last;
+	}
+	int len = 0;
+	for (int i = 0; i <= last && len < size; ++i) {
+		len += snprintf(buf + len, size - len, "%s%d", i == 0 ? "" : " ", histogram[i]);
+	}
+}
+
+void logAudioStats(const AudioStats *stats) {
+	if (stats->period == 0) {
+		return;
+	}
+	debug(DBG_AUDIO, "Audio callbacks %d (last minute), period %.1f ms, duration avg %.2f ms max %.2f ms (%d%%), interval max %.1f ms, underruns %d (%d total)",
+		stats->callbacks, stats->period / 1000., stats->avgDuration / 1000., stats->maxDuration / 1000., stats->maxDuration * 100 / stats->period,
+		stats->maxInterval / 1000., stats->underruns, stats->totalUnderruns);
+	char duration[128], interval[128];
+	formatHistogram(duration, sizeof(duration), stats->durationHistogram);
+	formatHistogram(interval, sizeof(interval), stats->intervalHistogram);
+	debug(DBG_AUDIO, "Audio duration histogram (%d%% of period) [%s], interval histogram (%d%% of period) [%s]",
+		AudioStats::kDurationBucketPercent, duration, AudioStats::kIntervalBucketPercent, interval);
+}
@@ -0,0 +1,41 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef AUDIO_STATS_H__
+#define AUDIO_STATS_H__
+
+#include "systemstub.h"
+
+// audio callback timings, updated by the audio thread and read with the audio device locked
+
+struct AudioTelemetry {
+	enum {
+		kSeconds = 60
+	};
+
+	struct Second {
+		uint64_t num;
+		uint32_t callbacks;
+		uint32_t underruns;
+		uint64_t durationSum; // us
+		uint32_t maxDuration, maxInterval; // us
+		uint32_t durationHistogram[AudioStats::kHistogramBuckets];
+		uint32_t intervalHistogram[AudioStats::kHistogramBuckets];
+	};
+
+	Second _seconds[kSeconds]; // last minute, indexed by second modulo kSeconds
+	uint64_t _prevTimestamp;
+	uint32_t _period, _lastDuration, _lastInterval; // us
+	uint32_t _totalCallbacks, _totalUnderruns;
+
+	void reset();
+	bool addCallback(uint64_t timestamp, uint32_t duration, uint32_t period);
+	void getStats(uint64_t now, AudioStats *stats) const;
+};
+
+extern void logAudioStats(const AudioStats *stats);
+
+#endif // AUDIO_STATS_H__
@@ -0,0 +1,309 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include <sys/param.h>
+#include "capture.h"
+#include "util.h"
+
+static int encoderThread(void *param) {
+	((VideoCapture *)param)->processFrames();
+	return 0;
+}
+
+static uint8_t clip8(int value) {
+	return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static void writeLE16(FILE *fp, uint16_t value) {
+	fputc(value & 255, fp);
+	fputc(value >> 8, fp);
+}
+
+static void writeLE32(FILE *fp, uint32_t value) {
+	writeLE16(fp, value & 0xFFFF);
+	writeLE16(fp, value >> 16);
+}
+
+VideoCapture::VideoCapture()
+	: _w(0), _h(0), _format(kFormatY4M), _videoFile(0), _audioFile(0), _sampleRate(0), _thread(0), _framesQueued(0), _framesFree(0),
+	_frameWrite(0), _frameRead(0), _started(false), _startTimestamp(0), _audioBuffer(0), _yuvFrame(0),
+	_hasFrame(false), _videoFramesCount(0), _audioSamplesCount(0), _deltaBuffer(0),
+	_encodedFramesCount(0), _keyframesCount(0), _encodedSize(0), _encodeTime(0) {
+	memset(_frames, 0, sizeof(_frames));
+	SDL_AtomicSet(&_pendingFrames, 0);
+	SDL_AtomicSet(&_quit, 0);
+	SDL_AtomicSet(&_audioWritePos, 0);
+	SDL_AtomicSet(&_audioReadPos, 0);
+	SDL_AtomicSet(&_audioStarted, 0);
+	SDL_AtomicSet(&_audioDropped, 0);
+}
+
+bool VideoCapture::init(const char *name, Format format, int w, int h, int sampleRate) {
+	_w = w;
+	_h = h;
+	_format = format;
+	_sampleRate = sampleRate;
+	char path[MAXPATHLEN];
+	snprintf(path, sizeof(path), "%s.%s", name, (format == kFormatDelta) ? "fbv" : "y4m");
+	_videoFile = fopen(path, "wb");
+	if (!_videoFile) {
+		warning("Unable to open '%s' for writing", path);
+		return false;
+	}
+	char audioPath[MAXPATHLEN];
+	snprintf(audioPath, sizeof(audioPath), "%s.wav", name);
+	_audioFile = fopen(audioPath, "wb");
+	if (!_audioFile) {
+		warning("Unable to open '%s' for writing", audioPath);
+		fini();
+		return false;
+	}
+	if (_format == kFormatDelta) {
+		if (!_delta.init(w, h) || (_deltaBuffer = (uint8_t *)malloc(_delta.getMaxFrameSize())) == 0) {
+			warning("Unable to allocate delta frames buffers");
+			fini();
+			return false;
+		}
+		uint8_t hdr[DeltaVideo::kHeaderSize];
+		_delta.writeHeader(hdr);
+		fwrite(hdr, sizeof(hdr), 1, _videoFile);
+	} else {
+		// 4:4:4 full range, the conversion of the palette colors does not lose any chroma resolution
+		fprintf(_videoFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", w, h, kFrameRate);
+	}
+	writeWavHeader();
+	for (int i = 0; i < kFramesCount; ++i) {
+		_frames[i].pixels = (uint8_t *)malloc(w * h);
+		if (!_frames[i].pixels) {
+			warning("Unable to allocate capture frame %d", i);
+			fini();
+			return false;
+		}
+	}
+	_audioBuffer = (int16_t *)malloc(kAudioBufferSize * sizeof(int16_t));
+	_yuvFrame = (uint8_t *)malloc(w * h * 3);
+	_framesQueued = SDL_CreateSemaphore(0);
+	_framesFree = SDL_CreateSemaphore(kFramesCount);
+	if (!_audioBuffer || !_yuvFrame || !_framesQueued || !_framesFree) {
+		warning("Unable to allocate capture buffers");
+		fini();
+		return false;
+	}
+	_thread = SDL_CreateThread(encoderThread, "VideoCapture", this);
+	if (!_thread) {
+		warning("Unable to create capture encoder thread");
+		fini();
+		return false;
+	}
+	debug(DBG_INFO, "Capturing to '%s' and '%s'", path, audioPath);
+	return true;
+}
+
+void VideoCapture::fini() {
+	SDL_AtomicSet(&_audioStarted, 0);
+	if (_thread) {
+		SDL_AtomicSet(&_quit, 1);
+		SDL_SemPost(_framesQueued);
+		SDL_WaitThread(_thread, 0);
+		_thread = 0;
+		if (_hasFrame) {
+			// the last frame is held until the next one, write it once
+			writeVideoFrame();
+		}
+		writeAudio();
+		printStats();
+	}
+	if (_videoFile) {
+		fclose(_videoFile);
+		_videoFile = 0;
+	}
+	if (_audioFile) {
+		writeWavHeader();
+		fclose(_audioFile);
+		_audioFile = 0;
+	}
+	for (int i = 0; i < kFramesCount; ++i) {
+		free(_frames[i].pixels);
+		_frames[i].pixels = 0;
+	}
+	free(_audioBuffer);
+	_audioBuffer = 0;
+	free(_yuvFrame);
+	_yuvFrame = 0;
+	free(_deltaBuffer);
+	_deltaBuffer = 0;
+	_delta.fini();
+	if (_framesQueued) {
+		SDL_DestroySemaphore(_framesQueued);
+		_framesQueued = 0;
+	}
+	if (_framesFree) {
+		SDL_DestroySemaphore(_framesFree);
+		_framesFree = 0;
+	}
+}
+
+void VideoCapture::pushFrame(const uint8_t *pixels, int pitch, const Color *palette, uint32_t timestamp) {
+	if (!_thread) {
+		return;
+	}
+	if (!_started) {
+		// the audio is recorded from the first frame
+		_started = true;
+		_startTimestamp = timestamp;
+		SDL_AtomicSet(&_audioStarted, 1);
+	}
+	// blocks only if the encoder is kFramesCount frames late
+	SDL_SemWait(_framesFree);
+	Frame *f = &_frames[_frameWrite];
+	for (int y = 0; y < _h; ++y) {
+		memcpy(f->pixels + y * _w, pixels + y * pitch, _w);
+	}
+	memcpy(f->palette, palette, sizeof(f->palette));
+	f->timestamp = timestamp - _startTimestamp;
+	_frameWrite = (_frameWrite + 1) & (kFramesCount - 1);
+	SDL_AtomicAdd(&_pendingFrames, 1);
+	SDL_SemPost(_framesQueued);
+}
+
+void VideoCapture::pushAudio(const int16_t *samples, int count) {
+	// called from the audio callback, never waits : the samples which do not fit are dropped
+	if (!SDL_AtomicGet(&_audioStarted)) {
+		return;
+	}
+	const int writePos = SDL_AtomicGet(&_audioWritePos);
+	const int readPos = SDL_AtomicGet(&_audioReadPos);
+	const int available = kAudioBufferSize - (writePos - readPos);
+	if (count > available) {
+		SDL_AtomicAdd(&_audioDropped, count - available);
+		count = available;
+	}
+	for (int i = 0; i < count; ++i) {
+		_audioBuffer[(writePos + i) & (kAudioBufferSize - 1)] = samples[i];
+	}
+	SDL_AtomicSet(&_audioWritePos, writePos + count);
+}
+
+void convertIndexedToYUV444(const uint8_t *pixels, const uint8_t *palette, int w, int h, uint8_t *dst) {
+	// BT.601 full range, the palette is converted once and the planes are looked up
+	uint8_t yuv[256][3];
+	for (int i = 0; i < 256; ++i) {
+		const int r = palette[i * 3];
+		const int g = palette[i * 3 + 1];
+		const int b = palette[i * 3 + 2];
+		yuv[i][0] = clip8((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+		yuv[i][1] = clip8(((-11059 * r - 21709 * g + 32768 * b + 32768) >> 16) + 128);
+		yuv[i][2] = clip8(((32768 * r - 27439 * g - 5329 * b + 32768) >> 16) + 128);
+	}
+	const int size = w * h;
+	uint8_t *y = dst;
+	uint8_t *u = dst + size;
+	uint8_t *v = dst + size * 2;
+	for (int i = 0; i < size; ++i) {
+		const uint8_t *color = yuv[pixels[i]];
+		y[i] = color[0];
+		u[i] = color[1];
+		v[i] = color[2];
+	}
+}
+
+void VideoCapture::encodeFrame(const Frame *f) {
+	convertIndexedToYUV444(f->pixels, f->palette, _w, _h, _yuvFrame);
+}
+
+void VideoCapture::encodeDeltaFrame(const Frame *f) {
+	const uint32_t size = _delta.encodeFrame(f->pixels, f->palette, f->timestamp, _deltaBuffer);
+	fwrite(_deltaBuffer, size, 1, _videoFile);
+	if (_deltaBuffer[4] & DeltaVideo::kFlagKeyframe) {
+		++_keyframesCount;
+	}
+	_encodedSize += size;
+}
+
+void VideoCapture::printStats() {
+	// the raw size is the indexed pixels and the palette of each frame
+	const uint64_t rawSize = (uint64_t)_encodedFramesCount * (_w * _h + 256 * 3);
+	if (_format == kFormatDelta) {
+		_encodedSize += DeltaVideo::kHeaderSize;
+		debug(DBG_INFO, "Captured %u frames (%u keyframes), %llu bytes, raw %llu bytes, ratio %.2f", _encodedFramesCount, _keyframesCount,
+			(unsigned long long)_encodedSize, (unsigned long long)rawSize, _encodedSize ? rawSize / (double)_encodedSize : 0.);
+	} else {
+		debug(DBG_INFO, "Captured %u frames, written %u frames at %d fps", _encodedFramesCount, _videoFramesCount, kFrameRate);
+	}
+	debug(DBG_INFO, "Encode time %.3f ms per frame, %u audio samples (%d dropped)", _encodedFramesCount ? _encodeTime / 1000000. / _encodedFramesCount : 0.,
+		_audioSamplesCount, SDL_AtomicGet(&_audioDropped));
+}
+
+void VideoCapture::writeVideoFrame() {
+	fputs("FRAME\n", _videoFile);
+	fwrite(_yuvFrame, _w * _h * 3, 1, _videoFile);
+	++_videoFramesCount;
+}
+
+void VideoCapture::writeAudio() {
+	const int writePos = SDL_AtomicGet(&_audioWritePos);
+	int readPos = SDL_AtomicGet(&_audioReadPos);
+	while (readPos != writePos) {
+		const int offset = readPos & (kAudioBufferSize - 1);
+		const int count = MIN(writePos - readPos, kAudioBufferSize - offset);
+		for (int i = 0; i < count; ++i) {
+			writeLE16(_audioFile, _audioBuffer[offset + i]);
+		}
+		readPos += count;
+		_audioSamplesCount += count;
+	}
+	SDL_AtomicSet(&_audioReadPos, readPos);
+}
+
+void VideoCapture::writeWavHeader() {
+	// written with zero sizes when the file is opened, rewritten with the final sizes by fini()
+	const uint32_t dataSize = _audioSamplesCount * sizeof(int16_t);
+	fseek(_audioFile, 0, SEEK_SET);
+	fwrite("RIFF", 4, 1, _audioFile);
+	writeLE32(_audioFile, 36 + dataSize);
+	fwrite("WAVEfmt ", 8, 1, _audioFile);
+	writeLE32(_audioFile, 16);
+	writeLE16(_audioFile, 1); // PCM
+	writeLE16(_audioFile, 1); // channels
+	writeLE32(_audioFile, _sampleRate);
+	writeLE32(_audioFile, _sampleRate * sizeof(int16_t));
+	writeLE16(_audioFile, sizeof(int16_t));
+	writeLE16(_audioFile, 16);
+	fwrite("data", 4, 1, _audioFile);
+	writeLE32(_audioFile, dataSize);
+	fseek(_audioFile, 0, SEEK_END);
+}
+
+void VideoCapture::processFrames() {
+	while (1) {
+		SDL_SemWait(_framesQueued);
+		if (SDL_AtomicGet(&_pendingFrames) == 0) {
+			// woken by fini(), all the queued frames are encoded
+			break;
+		}
+		const Frame *f = &_frames[_frameRead];
+		const uint64_t t = getTimeNs();
+		if (_format == kFormatDelta) {
+			encodeDeltaFrame(f);
+		} else {
+			// the y4m stream has a constant frame rate, the previous frame is repeated until the timestamp of this one
+			const uint32_t frameNum = (uint64_t)f->timestamp * kFrameRate / 1000;
+			if (_hasFrame) {
+				while (_videoFramesCount < frameNum) {
+					writeVideoFrame();
+				}
+			}
+			encodeFrame(f);
+			_hasFrame = true;
+		}
+		_encodeTime += getTimeNs() - t;
+		++_encodedFramesCount;
+		_frameRead = (_frameRead + 1) & (kFramesCount - 1);
+		SDL_AtomicAdd(&_pendingFrames, -1);
+		SDL_SemPost(_framesFree);
+		writeAudio();
+	}
+}
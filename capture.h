@@ -0,0 +1,84 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef CAPTURE_H__
+#define CAPTURE_H__
+
+#include <SDL.h>
+#include "intern.h"
+#include "delta_video.h"
+
+// records the presented frames to NAME.y4m or NAME.fbv and the mixed audio to NAME.wav, the
+// encoding and the disk writes are done by a background thread
+
+struct VideoCapture {
+	enum {
+		kFramesCount = 16, // must be a power of 2
+		kAudioBufferSize = 1 << 16, // samples, must be a power of 2
+		kFrameRate = 30
+	};
+
+	enum Format {
+		kFormatY4M,
+		kFormatDelta
+	};
+
+	struct Frame {
+		uint8_t palette[256 * 3];
+		uint8_t *pixels;
+		uint32_t timestamp;
+	};
+
+	int _w, _h;
+	Format _format;
+	FILE *_videoFile;
+	FILE *_audioFile;
+	int _sampleRate;
+	SDL_Thread *_thread;
+	SDL_sem *_framesQueued;
+	SDL_sem *_framesFree;
+	Frame _frames[kFramesCount];
+	int _frameWrite; // main thread
+	int _frameRead; // encoder thread
+	SDL_atomic_t _pendingFrames;
+	SDL_atomic_t _quit;
+	bool _started;
+	uint32_t _startTimestamp;
+	int16_t *_audioBuffer;
+	SDL_atomic_t _audioWritePos; // audio thread
+	SDL_atomic_t _audioReadPos; // encoder thread
+	SDL_atomic_t _audioStarted;
+	SDL_atomic_t _audioDropped;
+	uint8_t *_yuvFrame; // encoded frame, held until the timestamp of the next one
+	bool _hasFrame;
+	uint32_t _videoFramesCount;
+	uint32_t _audioSamplesCount;
+	DeltaVideo _delta;
+	uint8_t *_deltaBuffer;
+	uint32_t _encodedFramesCount;
+	uint32_t _keyframesCount;
+	uint64_t _encodedSize;
+	uint64_t _encodeTime;
+
+	VideoCapture();
+
+	bool init(const char *name, Format format, int w, int h, int sampleRate);
+	void fini();
+	void pushFrame(const uint8_t *pixels, int pitch, const Color *palette, uint32_t timestamp);
+	void pushAudio(const int16_t *samples, int count);
+
+	void encodeFrame(const Frame *f);
+	void encodeDeltaFrame(const Frame *f);
+	void writeVideoFrame();
+	void printStats();
+	void writeAudio();
+	void writeWavHeader();
+	void processFrames();
+};
+
+void convertIndexedToYUV444(const uint8_t *pixels, const uint8_t *palette, int w, int h, uint8_t *dst);
+
+#endif // CAPTURE_H__
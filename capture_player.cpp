@@ -0,0 +1,146 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include <getopt.h>
+#include "capture.h"
+#include "delta_video.h"
+#include "util.h"
+
+static const char *USAGE =
+	"REminiscence - Flashback Interpreter, captured video player\n"
+	"Usage: %s [OPTIONS]... FILE\n"
+	"  --y4m=FILE        Write the reconstructed frames to FILE\n"
+	"  --fps=NUM         Frame rate of the y4m file (default 30)\n"
+	"\n"
+	"FILE is a video recorded with --capture and --capture-delta.\n"
+;
+
+static bool readUint32BE(FILE *fp, uint32_t *value) {
+	uint8_t buf[4];
+	if (fread(buf, 1, 4, fp) != 4) {
+		return false;
+	}
+	*value = READ_BE_UINT32(buf);
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	const char *y4mPath = 0;
+	int fps = 30;
+	while (1) {
+		static struct option options[] = {
+			{ "y4m", required_argument, 0, 1 },
+			{ "fps", required_argument, 0, 2 },
+			{ 0, 0, 0, 0 }
+		};
+		int index;
+		const int c = getopt_long(argc, argv, "", options, &index);
+		if (c == -1) {
+			break;
+		}
+		switch (c) {
+		case 1:
+			y4mPath = strdup(optarg);
+			break;
+		case 2:
+			fps = atoi(optarg);
+			break;
+		default:
+			printf(USAGE, argv[0]);
+			return 0;
+		}
+	}
+	if (optind != argc - 1 || fps <= 0) {
+		printf(USAGE, argv[0]);
+		return 0;
+	}
+	g_debugMask = DBG_INFO;
+	FILE *fp = fopen(argv[optind], "rb");
+	if (!fp) {
+		error("Unable to open '%s'", argv[optind]);
+		return 1;
+	}
+	uint8_t hdr[DeltaVideo::kHeaderSize];
+	int w, h;
+	if (fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr) || !DeltaVideo::readHeader(hdr, &w, &h)) {
+		error("Unsupported file '%s'", argv[optind]);
+		return 1;
+	}
+	DeltaVideo dv;
+	uint8_t *frameBuffer = 0;
+	uint8_t *yuvFrame = (uint8_t *)malloc(w * h * 3);
+	if (!dv.init(w, h) || (frameBuffer = (uint8_t *)malloc(dv.getMaxFrameSize())) == 0 || !yuvFrame) {
+		error("Unable to allocate %dx%d frame buffers", w, h);
+		return 1;
+	}
+	FILE *y4m = 0;
+	if (y4mPath) {
+		y4m = fopen(y4mPath, "wb");
+		if (!y4m) {
+			error("Unable to open '%s' for writing", y4mPath);
+			return 1;
+		}
+		fprintf(y4m, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", w, h, fps);
+	}
+	uint32_t framesCount = 0, keyframesCount = 0, y4mFramesCount = 0;
+	uint64_t fileSize = sizeof(hdr);
+	uint64_t decodeTime = 0;
+	uint32_t timestamp = 0;
+	uint32_t size;
+	bool success = true;
+	while (readUint32BE(fp, &size)) {
+		if (size > dv.getMaxFrameSize() || fread(frameBuffer, 1, size, fp) != size) {
+			warning("Truncated frame %d", framesCount);
+			success = false;
+			break;
+		}
+		bool keyframe;
+		const uint64_t t = getTimeNs();
+		const bool ret = dv.decodeFrame(frameBuffer, size, &timestamp, &keyframe);
+		decodeTime += getTimeNs() - t;
+		if (!ret) {
+			warning("Invalid frame %d", framesCount);
+			success = false;
+			break;
+		}
+		if (y4m) {
+			// the frame is shown until the timestamp of the next one
+			const uint32_t frameNum = (uint64_t)timestamp * fps / 1000;
+			if (framesCount != 0) {
+				while (y4mFramesCount < frameNum) {
+					fputs("FRAME\n", y4m);
+					fwrite(yuvFrame, w * h * 3, 1, y4m);
+					++y4mFramesCount;
+				}
+			}
+			convertIndexedToYUV444(dv._pixels, dv._palette, w, h, yuvFrame);
+		}
+		++framesCount;
+		if (keyframe) {
+			++keyframesCount;
+		}
+		fileSize += 4 + size;
+	}
+	if (y4m) {
+		if (framesCount != 0) {
+			fputs("FRAME\n", y4m);
+			fwrite(yuvFrame, w * h * 3, 1, y4m);
+			++y4mFramesCount;
+		}
+		fclose(y4m);
+		debug(DBG_INFO, "Written %d frames to '%s'", y4mFramesCount, y4mPath);
+	}
+	fclose(fp);
+	const uint64_t rawSize = (uint64_t)framesCount * (w * h + 256 * 3);
+	printf("%d frames (%d keyframes) %dx%d, %.3f s\n", framesCount, keyframesCount, w, h, timestamp / 1000.);
+	printf("%llu bytes, raw %llu bytes, ratio %.2f, %.1f bytes per frame\n", (unsigned long long)fileSize, (unsigned long long)rawSize,
+		fileSize ? rawSize / (double)fileSize : 0., framesCount ? fileSize / (double)framesCount : 0.);
+	printf("Decode time %.3f ms per frame\n", framesCount ? decodeTime / 1000000. / framesCount : 0.);
+	free(frameBuffer);
+	free(yuvFrame);
+	dv.fini();
+	return success ? 0 : 1;
+}
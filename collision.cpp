@@ -9,19 +9,15 @@
 #include "util.h"
 
 void Game::col_prepareRoomState() {
-	memset(_col_activeCollisionSlots, 0xFF, sizeof(_col_activeCollisionSlots));
 	_col_currentLeftRoom = _res._ctData[CT_LEFT_ROOM + _currentRoom];
 	_col_currentRightRoom = _res._ctData[CT_RIGHT_ROOM + _currentRoom];
-	for (int i = 0; i != _col_curPos; ++i) {
-		CollisionSlot *_di = _col_slotsTable[i];
-		uint8_t room = _di->ct_pos / 64;
-		if (room == _currentRoom) {
-			_col_activeCollisionSlots[0x30 + (_di->ct_pos & 0x3F)] = i;
-		} else if (room == _col_currentLeftRoom) {
-			_col_activeCollisionSlots[0x00 + (_di->ct_pos & 0x3F)] = i;
-		} else if (room == _col_currentRightRoom) {
-			_col_activeCollisionSlots[0x60 + (_di->ct_pos & 0x3F)] = i;
-		}
+	// a slot belongs to a single area, the current room has priority over the left and right ones
+	const bool hasLeftRoom = (_col_currentLeftRoom != _currentRoom);
+	const bool hasRightRoom = (_col_currentRightRoom != _currentRoom && _col_currentRightRoom != _col_currentLeftRoom);
+	for (int i = 0; i < 0x30; ++i) {
+		_col_activeCollisionSlots[0x00 + i] = hasLeftRoom ? col_findSlot(_col_currentLeftRoom * 64 + i) : 0xFF;
+		_col_activeCollisionSlots[0x30 + i] = col_findSlot(_currentRoom * 64 + i);
+		_col_activeCollisionSlots[0x60 + i] = hasRightRoom ? col_findSlot(_col_currentRightRoom * 64 + i) : 0xFF;
 	}
 #ifdef DEBUG_COLLISION
 	printf("---\n");
@@ -37,6 +33,11 @@ void Game::col_prepareRoomState() {
 void Game::col_clearState() {
 	_col_curPos = 0;
 	_col_curSlot = _col_slots;
+	++_col_gridEpoch;
+	if (_col_gridEpoch == 0) {
+		memset(_col_gridEpochs, 0, sizeof(_col_gridEpochs));
+		_col_gridEpoch = 1;
+	}
 }
 
 void Game::col_preparePiegeState(LivePGE *pge) {
@@ -75,20 +76,22 @@ void Game::col_preparePiegeState(LivePGE *pge) {
 				ct_slot1->index = _ax;
 			}
 			LivePGE *temp_pge = ct_slot2->live_pge;
-			if (temp_pge->flags & 0x80) {
-				_pge_liveTable2[temp_pge->index] = temp_pge;
-				temp_pge->flags |= 4;
+			if (pge_flags(temp_pge) & 0x80) {
+				pge_activate(temp_pge);
+				pge_flags(temp_pge) |= 4;
 			}
 			if (ct_slot2->prev_slot) {
 				temp_pge = ct_slot2->prev_slot->live_pge;
-				if (temp_pge->flags & 0x80) {
-					_pge_liveTable2[temp_pge->index] = temp_pge;
-					temp_pge->flags |= 4;
+				if (pge_flags(temp_pge) & 0x80) {
+					pge_activate(temp_pge);
+					pge_flags(temp_pge) |= 4;
 				}
 			}
 		} else {
 			ct_slot2->prev_slot = 0;
 			_col_slotsTable[_col_curPos] = ct_slot2;
+			_col_gridSlots[pos] = _col_curPos;
+			_col_gridEpochs[pos] = _col_gridEpoch;
 			if (ct_slot1 == 0) {
 				pge->collision_slot = _col_curPos;
 			} else {
@@ -102,10 +105,10 @@ void Game::col_preparePiegeState(LivePGE *pge) {
 }
 
 uint16_t Game::col_getGridPos(LivePGE *pge, int16_t dx) {
-	int16_t x = pge->pos_x + dx;
-	int16_t y = pge->pos_y;
+	int16_t x = pge_posX(pge) + dx;
+	int16_t y = pge_posY(pge);
 
-	int8_t c = pge->room_location;
+	int8_t c = pge_roomLocation(pge);
 	if (c < 0) return 0xFFFF;
 
 	if (x < 0) {
@@ -136,9 +139,8 @@ uint16_t Game::col_getGridPos(LivePGE *pge, int16_t dx) {
 }
 
 int16_t Game::col_findSlot(int16_t pos) {
-	for (uint16_t i = 0; i < _col_curPos; ++i) {
-		if (_col_slotsTable[i]->ct_pos == pos)
-			return i;
+	if (pos >= 0 && pos < kColGridSize && _col_gridEpochs[pos] == _col_gridEpoch) {
+		return _col_gridSlots[pos];
 	}
 	return -1;
 }
@@ -153,31 +155,31 @@ int16_t Game::col_getGridData(LivePGE *pge, int16_t dy, int16_t dx) {
 	int8_t next_room;
 	if (pge_grid_x < 0) {
 		room_ct_data = &_res._ctData[CT_LEFT_ROOM];
-		next_room = room_ct_data[pge->room_location];
+		next_room = room_ct_data[pge_roomLocation(pge)];
 		if (next_room < 0) return 1;
 		room_ct_data += pge_grid_x + 16 + pge_grid_y * 16 + next_room * 0x70;
 		return (int16_t)room_ct_data[0x40];
 	} else if (pge_grid_x >= 16) {
 		room_ct_data = &_res._ctData[CT_RIGHT_ROOM];
-		next_room = room_ct_data[pge->room_location];
+		next_room = room_ct_data[pge_roomLocation(pge)];
 		if (next_room < 0) return 1;
 		room_ct_data += pge_grid_x - 16 + pge_grid_y * 16 + next_room * 0x70;
 		return (int16_t)room_ct_data[0x80];
 	} else if (pge_grid_y < 1) {
 		room_ct_data = &_res._ctData[CT_UP_ROOM];
-		next_room = room_ct_data[pge->room_location];
+		next_room = room_ct_data[pge_roomLocation(pge)];
 		if (next_room < 0) return 1;
 		room_ct_data += pge_grid_x + (pge_grid_y + 6) * 16 + next_room * 0x70;
 		return (int16_t)room_ct_data[0x100];
 	} else if (pge_grid_y >= 7) {
 		room_ct_data = &_res._ctData[CT_DOWN_ROOM];
-		next_room = room_ct_data[pge->room_location];
+		next_room = room_ct_data[pge_roomLocation(pge)];
 		if (next_room < 0) return 1;
 		room_ct_data += pge_grid_x + (pge_grid_y - 6) * 16 + next_room * 0x70;
 		return (int16_t)room_ct_data[0xC0];
 	} else {
 		room_ct_data = &_res._ctData[0x100];
-		room_ct_data += pge_grid_x + pge_grid_y * 16 + pge->room_location * 0x70;
+		room_ct_data += pge_grid_x + pge_grid_y * 16 + pge_roomLocation(pge) * 0x70;
 		return (int16_t)room_ct_data[0];
 	}
 }
@@ -227,7 +229,7 @@ int16_t Game::col_detectHit(LivePGE *pge, int16_t arg2, int16_t arg4, col_Callba
 	debug(DBG_COL, "col_detectHit()");
 	int16_t pos_dx, pos_dy, var8, varA;
 	int16_t collision_score = 0;
-	int8_t pge_room = pge->room_location;
+	int8_t pge_room = pge_roomLocation(pge);
 	if (pge_room < 0 || pge_room >= 0x40) {
 		return 0;
 	}
@@ -243,8 +245,8 @@ int16_t Game::col_detectHit(LivePGE *pge, int16_t arg2, int16_t arg4, col_Callba
 	if (_pge_currentPiegeFacingDir) {
 		pos_dx = -pos_dx;
 	}
-	int16_t grid_pos_x = (pge->pos_x + 8) >> 4;
-	int16_t grid_pos_y = (pge->pos_y / 72);
+	int16_t grid_pos_x = (pge_posX(pge) + 8) >> 4;
+	int16_t grid_pos_y = (pge_posY(pge) / 72);
 	if (grid_pos_y >= 0 && grid_pos_y <= 2) {
 		grid_pos_y *= 16;
 		collision_score = 0;
@@ -302,9 +304,9 @@ int Game::col_detectHitCallback6(LivePGE *pge, int16_t dy, int16_t unk1, int16_t
 }
 
 int Game::col_detectHitCallback2(LivePGE *pge1, LivePGE *pge2, int16_t unk1, int16_t unk2) {
-	if (pge1 != pge2 && (pge1->flags & 4)) {
+	if (pge1 != pge2 && (pge_flags(pge1) & 4)) {
 		if (pge1->init_PGE->object_type == unk2) {
-			if ((pge1->flags & 1) == (pge2->flags & 1)) {
+			if ((pge_flags(pge1) & 1) == (pge_flags(pge2) & 1)) {
 				if (col_detectHitCallbackHelper(pge1, unk1) == 0) {
 					return 1;
 				}
@@ -315,9 +317,9 @@ int Game::col_detectHitCallback2(LivePGE *pge1, LivePGE *pge2, int16_t unk1, int
 }
 
 int Game::col_detectHitCallback3(LivePGE *pge1, LivePGE *pge2, int16_t unk1, int16_t unk2) {
-	if (pge1 != pge2 && (pge1->flags & 4)) {
+	if (pge1 != pge2 && (pge_flags(pge1) & 4)) {
 		if (pge1->init_PGE->object_type == unk2) {
-			if ((pge1->flags & 1) != (pge2->flags & 1)) {
+			if ((pge_flags(pge1) & 1) != (pge_flags(pge2) & 1)) {
 				if (col_detectHitCallbackHelper(pge1, unk1) == 0) {
 					return 1;
 				}
@@ -328,9 +330,9 @@ int Game::col_detectHitCallback3(LivePGE *pge1, LivePGE *pge2, int16_t unk1, int
 }
 
 int Game::col_detectHitCallback4(LivePGE *pge1, LivePGE *pge2, int16_t unk1, int16_t unk2) {
-	if (pge1 != pge2 && (pge1->flags & 4)) {
+	if (pge1 != pge2 && (pge_flags(pge1) & 4)) {
 		if (pge1->init_PGE->object_type == unk2) {
-			if ((pge1->flags & 1) != (pge2->flags & 1)) {
+			if ((pge_flags(pge1) & 1) != (pge_flags(pge2) & 1)) {
 				if (col_detectHitCallbackHelper(pge1, unk1) == 0) {
 					pge_updateGroup(pge2->index, pge1->index, unk1);
 					return 1;
@@ -342,9 +344,9 @@ int Game::col_detectHitCallback4(LivePGE *pge1, LivePGE *pge2, int16_t unk1, int
 }
 
 int Game::col_detectHitCallback5(LivePGE *pge1, LivePGE *pge2, int16_t unk1, int16_t unk2) {
-	if (pge1 != pge2 && (pge1->flags & 4)) {
+	if (pge1 != pge2 && (pge_flags(pge1) & 4)) {
 		if (pge1->init_PGE->object_type == unk2) {
-			if ((pge1->flags & 1) == (pge2->flags & 1)) {
+			if ((pge_flags(pge1) & 1) == (pge_flags(pge2) & 1)) {
 				if (col_detectHitCallbackHelper(pge1, unk1) == 0) {
 					pge_updateGroup(pge2->index, pge1->index, unk1);
 					return 1;
@@ -361,7 +363,7 @@ int Game::col_detectHitCallbackHelper(LivePGE *pge, int16_t groupId) {
 	ObjectNode *on = _res._objectNodesMap[init_pge->obj_node_number];
 	Object *obj = &on->objects[pge->first_obj_number];
 	int i = pge->first_obj_number;
-	while (pge->obj_type == obj->type && on->last_obj_number > i) {
+	while (pge_objType(pge) == obj->type && on->last_obj_number > i) {
 		if (obj->opcode2 == 0x6B) { // pge_op_isInGroupSlice
 			if (obj->opcode_arg2 == 0) {
 				if (groupId == 1 || groupId == 2) return 0xFFFF;
@@ -400,10 +402,10 @@ int Game::col_detectGunHitCallback1(LivePGE *pge, int16_t arg2, int16_t arg4, in
 }
 
 int Game::col_detectGunHitCallback2(LivePGE *pge1, LivePGE *pge2, int16_t arg4, int16_t) {
-	if (pge1 != pge2 && (pge1->flags & 4)) {
+	if (pge1 != pge2 && (pge_flags(pge1) & 4)) {
 		if (pge1->init_PGE->object_type == 1 || pge1->init_PGE->object_type == 10) {
 			uint8_t id;
-			if ((pge1->flags & 1) != (pge2->flags & 1)) {
+			if ((pge_flags(pge1) & 1) != (pge_flags(pge2) & 1)) {
 				id = 4;
 				if (arg4 == 0) {
 					id = 3;
@@ -424,10 +426,10 @@ int Game::col_detectGunHitCallback2(LivePGE *pge1, LivePGE *pge2, int16_t arg4,
 }
 
 int Game::col_detectGunHitCallback3(LivePGE *pge1, LivePGE *pge2, int16_t arg4, int16_t) {
-	if (pge1 != pge2 && (pge1->flags & 4)) {
+	if (pge1 != pge2 && (pge_flags(pge1) & 4)) {
 		if (pge1->init_PGE->object_type == 1 || pge1->init_PGE->object_type == 12 || pge1->init_PGE->object_type == 10) {
 			uint8_t id;
-			if ((pge1->flags & 1) != (pge2->flags & 1)) {
+			if ((pge_flags(pge1) & 1) != (pge_flags(pge2) & 1)) {
 				id = 4;
 				if (arg4 == 0) {
 					id = 3;
@@ -449,7 +451,7 @@ int Game::col_detectGunHitCallback3(LivePGE *pge1, LivePGE *pge2, int16_t arg4,
 }
 
 int Game::col_detectGunHit(LivePGE *pge, int16_t arg2, int16_t arg4, col_Callback1 callback1, col_Callback2 callback2, int16_t argA, int16_t argC) {
-	int8_t pge_room = pge->room_location;
+	int8_t pge_room = pge_roomLocation(pge);
 	if (pge_room < 0 || pge_room >= 0x40) return 0;
 	int16_t thr, pos_dx, pos_dy;
 	if (argC == -1) {
@@ -468,8 +470,8 @@ int Game::col_detectGunHit(LivePGE *pge, int16_t arg2, int16_t arg4, col_Callbac
 	if (_pge_currentPiegeFacingDir) {
 		pos_dx = -pos_dx;
 	}
-	int16_t grid_pos_x = (pge->pos_x + 8) >> 4;
-	int16_t grid_pos_y = (pge->pos_y - 8) / 72;
+	int16_t grid_pos_x = (pge_posX(pge) + 8) >> 4;
+	int16_t grid_pos_y = (pge_posY(pge) - 8) / 72;
 	if (grid_pos_y >= 0 && grid_pos_y <= 2) {
 		grid_pos_y *= 16;
 		int16_t var8 = 0;
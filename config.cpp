@@ -0,0 +1,112 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include <ctype.h>
+#include "config.h"
+#include "fs.h"
+#include "util.h"
+
+const char *g_caption = "REminiscence";
+
+int detectVersion(FileSystem *fs) {
+	static const struct {
+		const char *filename;
+		int type;
+		const char *name;
+	} table[] = {
+		{ "DEMO_UK.ABA", kResourceTypeDOS, "DOS (Demo)" },
+		{ "INTRO.SEQ", kResourceTypeDOS, "DOS CD" },
+		{ "LEVEL1.MAP", kResourceTypeDOS, "DOS" },
+		{ "LEVEL1.LEV", kResourceTypeAmiga, "Amiga" },
+		{ "DEMO.LEV", kResourceTypeAmiga, "Amiga (Demo)" },
+		{ 0, -1, 0 }
+	};
+	// lookups in the files list built by the FileSystem scan, no file is opened
+	for (int i = 0; table[i].filename; ++i) {
+		if (fs->exists(table[i].filename)) {
+			debug(DBG_INFO, "Detected %s version", table[i].name);
+			return table[i].type;
+		}
+	}
+	return -1;
+}
+
+Language detectLanguage(FileSystem *fs) {
+	static const struct {
+		const char *filename;
+		Language language;
+	} table[] = {
+		// PC
+		{ "ENGCINE.TXT", LANG_EN },
+		{ "FR_CINE.TXT", LANG_FR },
+		{ "GERCINE.TXT", LANG_DE },
+		{ "SPACINE.TXT", LANG_SP },
+		{ "ITACINE.TXT", LANG_IT },
+		// Amiga
+		{ "FRCINE.TXT", LANG_FR },
+		{ 0, LANG_EN }
+	};
+	for (int i = 0; table[i].filename; ++i) {
+		if (fs->exists(table[i].filename)) {
+			return table[i].language;
+		}
+	}
+	return LANG_EN;
+}
+
+void initOptions(Options *options) {
+	// defaults
+	options->bypass_protection = true;
+	options->play_disabled_cutscenes = false;
+	options->enable_password_menu = false;
+	options->fade_out_palette = true;
+	options->use_tiledata = false;
+	options->use_text_cutscenes = false;
+	options->use_seq_cutscenes = true;
+	options->enable_rewind = true;
+	// read configuration file
+	struct {
+		const char *name;
+		bool *value;
+	} opts[] = {
+		{ "bypass_protection", &options->bypass_protection },
+		{ "play_disabled_cutscenes", &options->play_disabled_cutscenes },
+		{ "enable_password_menu", &options->enable_password_menu },
+		{ "fade_out_palette", &options->fade_out_palette },
+		{ "use_tiledata", &options->use_tiledata },
+		{ "use_text_cutscenes", &options->use_text_cutscenes },
+		{ "use_seq_cutscenes", &options->use_seq_cutscenes },
+		{ "enable_rewind", &options->enable_rewind },
+		{ 0, 0 }
+	};
+	static const char *filename = "rs.cfg";
+	FILE *fp = fopen(filename, "rb");
+	if (fp) {
+		char buf[256];
+		while (fgets(buf, sizeof(buf), fp)) {
+			if (buf[0] == '#') {
+				continue;
+			}
+			const char *p = strchr(buf, '=');
+			if (p) {
+				++p;
+				while (*p && isspace(*p)) {
+					++p;
+				}
+				if (*p) {
+					const bool value = (*p == 't' || *p == 'T' || *p == '1');
+					for (int i = 0; opts[i].name; ++i) {
+						if (strncmp(buf, opts[i].name, strlen(opts[i].name)) == 0) {
+							*opts[i].value = value;
+							break;
+						}
+					}
+				}
+			}
+		}
+		fclose(fp);
+	}
+}
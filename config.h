@@ -0,0 +1,18 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef CONFIG_H__
+#define CONFIG_H__
+
+#include "intern.h"
+
+struct FileSystem;
+
+int detectVersion(FileSystem *fs); // ResourceType, -1 if the data files are not found
+Language detectLanguage(FileSystem *fs);
+void initOptions(Options *options); // defaults, then 'rs.cfg'
+
+#endif // CONFIG_H__
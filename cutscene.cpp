@@ -11,8 +11,8 @@
 #include "util.h"
 #include "video.h"
 
-Cutscene::Cutscene(Resource *res, SystemStub *stub, Video *vid)
-	: _res(res), _stub(stub), _vid(vid) {
+Cutscene::Cutscene(Resource *res, SystemStub *stub, Video *vid, const Options *options)
+	: _res(res), _stub(stub), _vid(vid), _options(options) {
 	_patchedOffsetsTable = 0;
 	memset(_palBuf, 0, sizeof(_palBuf));
 }
@@ -24,12 +24,7 @@ void Cutscene::sync() {
 	if (_stub->_pi.dbgMask & PlayerInput::DF_FASTMODE) {
 		return;
 	}
-	const int32_t delay = _stub->getTimeStamp() - _tstamp;
-	const int32_t pause = _frameDelay * TIMER_SLICE - delay;
-	if (pause > 0) {
-		_stub->sleep(pause);
-	}
-	_tstamp = _stub->getTimeStamp();
+	_stub->_scheduler.waitMs(_frameDelay * TIMER_SLICE);
 }
 
 void Cutscene::copyPalette(const uint8_t *pal, uint16_t num) {
@@ -917,7 +912,7 @@ uint16_t Cutscene::fetchNextCmdWord() {
 
 void Cutscene::mainLoop(uint16_t offset) {
 	_frameDelay = 5;
-	_tstamp = _stub->getTimeStamp();
+	_stub->_scheduler.reset();
 
 	Color c;
 	c.r = c.g = c.b = 0;
@@ -1054,7 +1049,7 @@ void Cutscene::playText(const char *str) {
 			_stub->_pi.backspace = false;
 			break;
 		}
-		_stub->sleep(TIMER_SLICE);
+		_stub->_scheduler.waitMs(TIMER_SLICE);
 	}
 }
 
@@ -1066,7 +1061,7 @@ void Cutscene::play() {
 		prepare();
 		uint16_t cutName = _offsetsTable[_id * 2 + 0];
 		uint16_t cutOff  = _offsetsTable[_id * 2 + 1];
-		if (cutName == 0xFFFF && g_options.play_disabled_cutscenes) {
+		if (cutName == 0xFFFF && _options->play_disabled_cutscenes) {
 			switch (_id) {
 			case 19:
 				cutName = 31; // SERRURE
@@ -1091,7 +1086,7 @@ void Cutscene::play() {
 				}
 			}
 		}
-		if (g_options.use_text_cutscenes) {
+		if (_options->use_text_cutscenes) {
 			const Text *textsTable = (_res->_lang == LANG_FR) ? _frTextsTable : _enTextsTable;
 			for (int i = 0; textsTable[i].str; ++i) {
 				if (_id == textsTable[i].num) {
@@ -46,6 +46,7 @@ struct Cutscene {
 	Resource *_res;
 	SystemStub *_stub;
 	Video *_vid;
+	const Options *_options;
 	const uint8_t *_patchedOffsetsTable;
 
 	uint16_t _id;
@@ -55,7 +56,6 @@ struct Cutscene {
 	uint8_t *_polPtr;
 	uint8_t *_cmdPtr;
 	uint8_t *_cmdPtrBak;
-	uint32_t _tstamp;
 	uint8_t _frameDelay;
 	bool _newPal;
 	uint8_t _palBuf[0x20 * 2];
@@ -91,7 +91,7 @@ struct Cutscene {
 	int16_t _creditsTextCounter;
 	uint8_t *_page0, *_page1, *_pageC;
 
-	Cutscene(Resource *res, SystemStub *stub, Video *vid);
+	Cutscene(Resource *res, SystemStub *stub, Video *vid, const Options *options);
 
 	void sync();
 	void copyPalette(const uint8_t *pal, uint16_t num);
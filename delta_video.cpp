@@ -0,0 +1,187 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include "delta_video.h"
+#include "util.h"
+
+static void WRITE_BE_UINT16(uint8_t *dst, uint16_t value) {
+	dst[0] = value >> 8;
+	dst[1] = value & 255;
+}
+
+static void WRITE_BE_UINT32(uint8_t *dst, uint32_t value) {
+	WRITE_BE_UINT16(dst, value >> 16);
+	WRITE_BE_UINT16(dst + 2, value & 0xFFFF);
+}
+
+DeltaVideo::DeltaVideo()
+	: _w(0), _h(0), _blocksW(0), _blocksH(0), _pixels(0), _framesSinceKeyframe(0) {
+	memset(_palette, 0, sizeof(_palette));
+}
+
+bool DeltaVideo::init(int w, int h) {
+	assert((w % kBlockSize) == 0 && (h % kBlockSize) == 0);
+	_w = w;
+	_h = h;
+	_blocksW = w / kBlockSize;
+	_blocksH = h / kBlockSize;
+	_pixels = (uint8_t *)calloc(1, w * h);
+	_framesSinceKeyframe = 0;
+	return _pixels != 0;
+}
+
+void DeltaVideo::fini() {
+	free(_pixels);
+	_pixels = 0;
+}
+
+uint32_t DeltaVideo::getMaxFrameSize() const {
+	// a keyframe, the frames with the masks and all the blocks are larger but encoded as keyframes
+	return kFrameHeaderSize + sizeof(_palette) + _w * _h;
+}
+
+void DeltaVideo::writeHeader(uint8_t *dst) const {
+	WRITE_BE_UINT32(dst, kTag);
+	WRITE_BE_UINT16(dst + 4, kVersion);
+	WRITE_BE_UINT16(dst + 6, _w);
+	WRITE_BE_UINT16(dst + 8, _h);
+	WRITE_BE_UINT16(dst + 10, kKeyframeInterval);
+}
+
+uint32_t DeltaVideo::encodeFrame(const uint8_t *pixels, const uint8_t *palette, uint32_t timestamp, uint8_t *dst) {
+	bool keyframe = (_framesSinceKeyframe == 0);
+	uint8_t *p = dst + kFrameHeaderSize;
+	if (!keyframe) {
+		uint8_t flags = 0;
+		if (memcmp(palette, _palette, sizeof(_palette)) != 0) {
+			flags |= kFlagPalette;
+			uint8_t *mask = p;
+			memset(mask, 0, 32);
+			p += 32;
+			for (int i = 0; i < 256; ++i) {
+				if (memcmp(palette + i * 3, _palette + i * 3, 3) != 0) {
+					mask[i >> 3] |= 0x80 >> (i & 7);
+					memcpy(p, palette + i * 3, 3);
+					p += 3;
+				}
+			}
+		}
+		const int blocksCount = _blocksW * _blocksH;
+		uint8_t *mask = p;
+		memset(mask, 0, (blocksCount + 7) / 8);
+		p += (blocksCount + 7) / 8;
+		for (int by = 0; by < _blocksH; ++by) {
+			for (int bx = 0; bx < _blocksW; ++bx) {
+				const int offset = (by * _w + bx) * kBlockSize;
+				bool dirty = false;
+				for (int y = 0; y < kBlockSize && !dirty; ++y) {
+					dirty = memcmp(pixels + offset + y * _w, _pixels + offset + y * _w, kBlockSize) != 0;
+				}
+				if (dirty) {
+					const int num = by * _blocksW + bx;
+					if (p - dst + kBlockSize * kBlockSize > (int)getMaxFrameSize()) {
+						// the dirty blocks do not fit, store the whole frame
+						keyframe = true;
+						break;
+					}
+					mask[num >> 3] |= 0x80 >> (num & 7);
+					for (int y = 0; y < kBlockSize; ++y) {
+						memcpy(p, pixels + offset + y * _w, kBlockSize);
+						p += kBlockSize;
+					}
+				}
+			}
+			if (keyframe) {
+				break;
+			}
+		}
+		dst[4] = flags;
+	}
+	if (keyframe) {
+		p = dst + kFrameHeaderSize;
+		memcpy(p, palette, sizeof(_palette));
+		p += sizeof(_palette);
+		memcpy(p, pixels, _w * _h);
+		p += _w * _h;
+		dst[4] = kFlagKeyframe | kFlagPalette;
+	}
+	WRITE_BE_UINT32(dst + 5, timestamp);
+	const uint32_t size = p - dst;
+	WRITE_BE_UINT32(dst, size - 4);
+	memcpy(_pixels, pixels, _w * _h);
+	memcpy(_palette, palette, sizeof(_palette));
+	if (keyframe) {
+		_framesSinceKeyframe = 0;
+	}
+	if (++_framesSinceKeyframe >= kKeyframeInterval) {
+		_framesSinceKeyframe = 0;
+	}
+	return size;
+}
+
+bool DeltaVideo::readHeader(const uint8_t *src, int *w, int *h) {
+	if (READ_BE_UINT32(src) != kTag || READ_BE_UINT16(src + 4) != kVersion) {
+		return false;
+	}
+	*w = READ_BE_UINT16(src + 6);
+	*h = READ_BE_UINT16(src + 8);
+	return true;
+}
+
+bool DeltaVideo::decodeFrame(const uint8_t *src, uint32_t size, uint32_t *timestamp, bool *keyframe) {
+	// 'src' points after the frame size
+	if (size < kFrameHeaderSize - 4) {
+		return false;
+	}
+	const uint8_t *end = src + size;
+	const uint8_t flags = src[0];
+	*timestamp = READ_BE_UINT32(src + 1);
+	*keyframe = (flags & kFlagKeyframe) != 0;
+	const uint8_t *p = src + 5;
+	if (*keyframe) {
+		if (end - p != (int)sizeof(_palette) + _w * _h) {
+			return false;
+		}
+		memcpy(_palette, p, sizeof(_palette));
+		memcpy(_pixels, p + sizeof(_palette), _w * _h);
+		return true;
+	}
+	if (flags & kFlagPalette) {
+		if (p + 32 > end) {
+			return false;
+		}
+		const uint8_t *mask = p;
+		p += 32;
+		for (int i = 0; i < 256; ++i) {
+			if (mask[i >> 3] & (0x80 >> (i & 7))) {
+				if (p + 3 > end) {
+					return false;
+				}
+				memcpy(_palette + i * 3, p, 3);
+				p += 3;
+			}
+		}
+	}
+	const int blocksCount = _blocksW * _blocksH;
+	if (p + (blocksCount + 7) / 8 > end) {
+		return false;
+	}
+	const uint8_t *mask = p;
+	p += (blocksCount + 7) / 8;
+	for (int num = 0; num < blocksCount; ++num) {
+		if (mask[num >> 3] & (0x80 >> (num & 7))) {
+			if (p + kBlockSize * kBlockSize > end) {
+				return false;
+			}
+			const int offset = ((num / _blocksW) * _w + (num % _blocksW)) * kBlockSize;
+			for (int y = 0; y < kBlockSize; ++y) {
+				memcpy(_pixels + offset + y * _w, p, kBlockSize);
+				p += kBlockSize;
+			}
+		}
+	}
+	return p == end;
+}
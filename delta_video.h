@@ -0,0 +1,52 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef DELTA_VIDEO_H__
+#define DELTA_VIDEO_H__
+
+#include "intern.h"
+
+// indexed frames recording : the file starts with
+//   [u32 'FBVD'][u16 version][u16 width][u16 height][u16 keyframe interval]
+// followed by the frames, each one is [u32 size][u8 flags][u32 timestamp (ms)] and
+//   keyframe : the 256 colors palette (768 bytes), the indexed pixels
+//   other frames : if the palette changed, a 256 bits mask of the changed colors followed by
+//   their RGB values ; a mask of the 8x8 blocks differing from the previous frame, followed
+//   by the pixels of these blocks
+// All the values are big endian.
+
+struct DeltaVideo {
+	enum {
+		kTag = 0x46425644, // 'FBVD'
+		kVersion = 1,
+		kHeaderSize = 12,
+		kFrameHeaderSize = 9,
+		kBlockSize = 8,
+		kKeyframeInterval = 60,
+		kFlagKeyframe = 1 << 0,
+		kFlagPalette = 1 << 1
+	};
+
+	int _w, _h;
+	int _blocksW, _blocksH;
+	uint8_t *_pixels; // previous frame
+	uint8_t _palette[256 * 3];
+	int _framesSinceKeyframe;
+
+	DeltaVideo();
+
+	bool init(int w, int h);
+	void fini();
+	uint32_t getMaxFrameSize() const;
+
+	void writeHeader(uint8_t *dst) const;
+	uint32_t encodeFrame(const uint8_t *pixels, const uint8_t *palette, uint32_t timestamp, uint8_t *dst);
+
+	static bool readHeader(const uint8_t *src, int *w, int *h);
+	bool decodeFrame(const uint8_t *src, uint32_t size, uint32_t *timestamp, bool *keyframe);
+};
+
+#endif // DELTA_VIDEO_H__
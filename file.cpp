@@ -26,6 +26,7 @@ struct File_impl {
 	virtual void seek(int32_t off) = 0;
 	virtual uint32_t read(void *ptr, uint32_t len) = 0;
 	virtual uint32_t write(const void *ptr, uint32_t len) = 0;
+	virtual uint8_t *releaseBuffer(uint32_t *size) { return 0; }
 };
 
 struct StdioFile : File_impl {
@@ -79,6 +80,64 @@ struct StdioFile : File_impl {
 	}
 };
 
+struct MemoryFile : File_impl {
+	uint8_t *_buf;
+	uint32_t _size, _capacity, _pos;
+	MemoryFile() : _buf(0), _size(0), _capacity(0), _pos(0) {}
+	bool open(const char *path, const char *mode) {
+		_ioErr = false;
+		return true;
+	}
+	void close() {
+		free(_buf);
+		_buf = 0;
+		_size = _capacity = _pos = 0;
+	}
+	uint32_t size() {
+		return _size;
+	}
+	void seek(int32_t off) {
+		_pos = off;
+	}
+	uint32_t read(void *ptr, uint32_t len) {
+		if (_pos + len > _size) {
+			_ioErr = true;
+			len = (_pos < _size) ? _size - _pos : 0;
+		}
+		memcpy(ptr, _buf + _pos, len);
+		_pos += len;
+		return len;
+	}
+	uint32_t write(const void *ptr, uint32_t len) {
+		if (_pos + len > _capacity) {
+			uint32_t capacity = _capacity ? _capacity : 4096;
+			while (capacity < _pos + len) {
+				capacity *= 2;
+			}
+			uint8_t *buf = (uint8_t *)realloc(_buf, capacity);
+			if (!buf) {
+				_ioErr = true;
+				return 0;
+			}
+			_buf = buf;
+			_capacity = capacity;
+		}
+		memcpy(_buf + _pos, ptr, len);
+		_pos += len;
+		if (_pos > _size) {
+			_size = _pos;
+		}
+		return len;
+	}
+	uint8_t *releaseBuffer(uint32_t *size) {
+		uint8_t *buf = _buf;
+		*size = _size;
+		_buf = 0;
+		_size = _capacity = _pos = 0;
+		return buf;
+	}
+};
+
 #ifdef USE_ZLIB
 struct GzipFile : File_impl {
 	gzFile _fp;
@@ -264,6 +323,19 @@ bool File::open(const char *filename, const char *mode, const char *directory) {
 	return _impl->open(path, mode);
 }
 
+bool File::openMemory() {
+	if (_impl) {
+		_impl->close();
+		delete _impl;
+	}
+	_impl = new MemoryFile;
+	return _impl->open(0, 0);
+}
+
+uint8_t *File::releaseMemoryBuffer(uint32_t *size) {
+	return _impl->releaseBuffer(size);
+}
+
 void File::close() {
 	if (_impl) {
 		_impl->close();
@@ -20,6 +20,8 @@ struct File {
 
 	bool open(const char *filename, const char *mode, FileSystem *fs);
 	bool open(const char *filename, const char *mode, const char *directory);
+	bool openMemory();
+	uint8_t *releaseMemoryBuffer(uint32_t *size);
 	void close();
 	bool ioErr() const;
 	uint32_t size();
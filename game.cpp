@@ -5,6 +5,7 @@
  */
 
 #include <ctime>
+#include "capture.h"
 #include "file.h"
 #include "fs.h"
 #include "game.h"
@@ -13,86 +14,95 @@
 #include "unpack.h"
 #include "util.h"
 
-Game::Game(SystemStub *stub, FileSystem *fs, const char *savePath, int level, int demo, ResourceType ver, Language lang)
-	: _cut(&_res, stub, &_vid), _menu(&_res, stub, &_vid),
-	_mix(fs, stub), _res(fs, ver, lang), _seq(stub, &_mix), _vid(&_res, stub),
+Game::Game(SystemStub *stub, FileSystem *fs, const char *savePath, int level, int demo, ResourceType ver, Language lang, const Options &options)
+	: _options(options), _cut(&_res, stub, &_vid, &_options), _menu(&_res, stub, &_vid, &_options),
+	_mix(fs, stub), _res(fs, ver, lang), _seq(stub, &_mix), _vid(&_res, stub, &_options),
 	_stub(stub), _fs(fs), _savePath(savePath) {
 	_stateSlot = 1;
 	_inp_demPos = 0;
 	_skillLevel = _menu._skill = 1;
 	_currentLevel = _menu._level = level;
 	_demoBin = demo;
+	_demoStart = false;
+	_levelChangePending = false;
+	_benchmark = false;
+	_profile = false;
+	memset(_profileStats, 0, sizeof(_profileStats));
+	memset(_col_gridEpochs, 0, sizeof(_col_gridEpochs));
+	_col_gridEpoch = 0;
+	_rewindState = 0;
+	_hashTracePath = _hashComparePath = 0;
+	_hashTraceFile = _hashCompareFile = 0;
+	_hashState = 0;
+	_recordPath = _replayPath = 0;
+	_recordFile = 0;
+	_capturePath = 0;
+	_captureDelta = false;
+	_capture = 0;
+	_startupTime = getTimeNs();
+	_startupEventsCount = 0;
+	_firstFramePresented = false;
+	_globalBanksLoaded = false;
+	_startupParallel = true;
+	// snapshots copy these tables as is, clear the structures padding once
+	memset(_pgeLive, 0, sizeof(_pgeLive));
+	memset(&_pgeHot, 0, sizeof(_pgeHot));
+	memset(_pge_groups, 0, sizeof(_pge_groups));
+	memset(_col_slots, 0, sizeof(_col_slots));
+	memset(_col_slots2, 0, sizeof(_col_slots2));
 }
 
 void Game::run() {
 	_randSeed = time(0);
+	_framesCount = 0;
 
-	if (_demoBin != -1) {
+	if (_replayPath) {
+		_demoBin = kDemoReplay;
+		if (!inp_loadRecording(_replayPath)) {
+			return;
+		}
+		_demoStart = true;
+	} else if (_demoBin != -1) {
 		if (_demoBin < ARRAYSIZE(_demoInputs)) {
-			const char *fn = _demoInputs[_demoBin].name;
-			debug(DBG_INFO, "Loading inputs from '%s'", fn);
-			_res.load_DEM(fn);
+			_demo = _demoInputs[_demoBin];
+			_demoSeed = 0;
+			debug(DBG_INFO, "Loading inputs from '%s'", _demo.name);
+			_res.load_DEM(_demo.name);
 		}
 		if (_res._demLen == 0) {
 			return;
 		}
 	}
 
-	_res.init();
-	_res.load_TEXT();
-
-	switch (_res._type) {
-	case kResourceTypeAmiga:
-		_res.load("FONT8", Resource::OT_FNT, "SPR");
-		if (_res._isDemo) {
-			_cut._patchedOffsetsTable = Cutscene::_amigaDemoOffsetsTable;
-		}
-		break;
-	case kResourceTypeDOS:
-		_res.load("FB_TXT", Resource::OT_FNT);
-		if (g_options.use_seq_cutscenes) {
-			_res._hasSeqData = _fs->exists("INTRO.SEQ");
-		}
-		if (_fs->exists("logosssi.cmd")) {
-			_cut._patchedOffsetsTable = Cutscene::_ssiOffsetsTable;
-		}
-		break;
-	}
+	runStartupTasks();
 
-	if (!g_options.bypass_protection) {
+	if (!_options.bypass_protection) {
 		while (!handleProtectionScreen());
 		if (_stub->_pi.quit) {
+			_res.free_TEXT();
+			_mix.free();
 			return;
 		}
+		markStartupEvent("protection screen");
 	}
 
-	_mix.init();
-	_mix._mod._isAmiga = _res.isAmiga();
+	if (_capturePath) {
+		initCapture();
+	}
 
 	if (_demoBin == -1) {
 		playCutscene(0x40);
 		playCutscene(0x0D);
+		markStartupEvent("intro cutscenes");
 	}
 
-	switch (_res._type) {
-	case kResourceTypeAmiga:
-		_res.load("ICONE", Resource::OT_ICN, "SPR");
-		_res.load("ICON", Resource::OT_ICN, "SPR");
-		_res.load("PERSO", Resource::OT_SPM);
-		break;
-	case kResourceTypeDOS:
-		_res.load("GLOBAL", Resource::OT_ICN);
-		_res.load("GLOBAL", Resource::OT_SPC);
-		_res.load("PERSO", Resource::OT_SPR);
-		_res.load_SPR_OFF("PERSO", _res._spr1);
-		_res.load_FIB("GLOBAL");
-		break;
-	}
-
+	initRewind();
+	_stateWriter.init();
+	const bool hashState = (_hashTracePath || _hashComparePath) && initStateHash();
 	while (!_stub->_pi.quit) {
 		if (_demoBin != -1) {
-			_currentLevel = _demoInputs[_demoBin].level;
-			_randSeed = 0;
+			_currentLevel = _demo.level;
+			_randSeed = _demoSeed;
 		} else if (_res._isDemo) {
 			// do not present title screen and menus
 		} else {
@@ -116,6 +126,11 @@ void Game::run() {
 			if (_stub->_pi.quit) {
 				break;
 			}
+			markStartupEvent("title screen");
+		}
+		if (!_globalBanksLoaded) {
+			loadGlobalBanks();
+			_globalBanksLoaded = true;
 		}
 		if (_currentLevel == 7) {
 			_vid.fadeOut();
@@ -128,20 +143,56 @@ void Game::run() {
 			_vid._unkPalSlot1 = 0;
 			_vid._unkPalSlot2 = 0;
 			_score = 0;
+			const uint32_t seed = _randSeed;
 			loadLevelData();
 			resetGameState();
+			markStartupEvent("level data");
+			if (_recordPath && _demoBin == -1) {
+				inp_startRecording(seed);
+			}
 			_endLoop = false;
-			_frameTimestamp = _stub->getTimeStamp();
+			_levelChangePending = false;
+			_stub->_scheduler.reset();
+			_benchFrames = _benchPgeCount = 0;
+			_benchPgeTime = _benchColTime = 0;
+			_benchStartTime = getTimeNs();
+			_rewindFrames = 0;
+			_rewindTime = 0;
 			while (!_stub->_pi.quit && !_endLoop) {
 				mainLoop();
+				++_framesCount;
+				if (hashState) {
+					hashFrameState();
+				}
 				if (_demoBin != -1 && _inp_demPos >= _res._demLen) {
 					debug(DBG_INFO, "End of demo");
 					_stub->_pi.quit = true;
 				}
 			}
+			if (_recordFile) {
+				inp_stopRecording();
+			}
+			if (_benchmark) {
+				printBenchmark();
+				benchmarkSnapshot();
+				benchmarkCollision();
+			}
 		}
 	}
 
+	if (_profile) {
+		printStartupTimeline();
+		_stub->_scheduler.printStats();
+		printProfile();
+	}
+	freeProfile();
+	finiRewind();
+	_stateWriter.fini();
+	if (hashState) {
+		finiStateHash();
+	}
+
+	finiCapture();
 	_res.free_TEXT();
 	_mix.free();
 	_res.fini();
@@ -175,7 +226,7 @@ void Game::displayTitleScreenAmiga() {
 		const int y = kH / 2 - h;
 		_stub->copyRect(0, y, kW, h * 2, buf, kW);
 		_stub->updateScreen(0);
-		_stub->sleep(30);
+		_stub->_scheduler.waitMs(30);
 	}
 	while (1) {
 		_stub->processEvents();
@@ -186,7 +237,7 @@ void Game::displayTitleScreenAmiga() {
 			_stub->_pi.enter = false;
 			break;
 		}
-		_stub->sleep(30);
+		_stub->_scheduler.waitMs(30);
 	}
 }
 
@@ -213,13 +264,24 @@ void Game::resetGameState() {
 }
 
 void Game::mainLoop() {
+	if (_levelChangePending) {
+		// the frames keep being presented and paced during the palette fade
+		if (_vid.isPaletteFading()) {
+			_vid.updateScreen();
+			_stub->processEvents();
+			updateTiming();
+			return;
+		}
+		_levelChangePending = false;
+		loadNextLevel();
+	}
 	playCutscene();
 	if (_cut._id == 0x3D) {
 		showFinalScore();
 		_endLoop = true;
 		return;
 	}
-	if (_deathCutsceneCounter) {
+	if (_deathCutsceneCounter && !_rewinding) {
 		--_deathCutsceneCounter;
 		if (_deathCutsceneCounter == 0) {
 			playCutscene(_cut._deathCutsceneId);
@@ -239,38 +301,50 @@ void Game::mainLoop() {
 			return;
 		}
 	}
+	uint64_t phaseTime = getTimeNs();
 	memcpy(_vid._frontLayer, _vid._backLayer, _vid._layerSize);
 	pge_getInput();
-	pge_prepare();
-	col_prepareRoomState();
-	uint8_t oldLevel = _currentLevel;
-	for (uint16_t i = 0; i < _res._pgeNum; ++i) {
-		LivePGE *pge = _pge_liveTable2[i];
-		if (pge) {
-			_col_currentPiegeGridPosY = (pge->pos_y / 36) & ~1;
-			_col_currentPiegeGridPosX = (pge->pos_x + 8) >> 4;
+	markPerfPhase(PerfStats::PHASE_INPUT, &phaseTime);
+	if (!_rewinding) { // the state restored from the rewind buffer is only redrawn
+		const uint64_t colStartTime = _benchmark ? getTimeNs() : 0;
+		pge_prepare();
+		col_prepareRoomState();
+		uint8_t oldLevel = _currentLevel;
+		const uint64_t pgeStartTime = _benchmark ? getTimeNs() : 0;
+		_benchColTime += pgeStartTime - colStartTime;
+		// pieges woken up by an earlier one in the loop are processed during the same frame
+		for (int i = pge_getNextActive(0); i >= 0 && i < _res._pgeNum; i = pge_getNextActive(i + 1)) {
+			LivePGE *pge = &_pgeLive[i];
+			_col_currentPiegeGridPosY = (pge_posY(pge) / 36) & ~1;
+			_col_currentPiegeGridPosX = (pge_posX(pge) + 8) >> 4;
 			pge_process(pge);
+			++_benchPgeCount;
 		}
-	}
-	if (oldLevel != _currentLevel) {
-		if (_res._isDemo) {
-			_currentLevel = oldLevel;
+		if (_benchmark) {
+			_benchPgeTime += getTimeNs() - pgeStartTime;
+			++_benchFrames;
+		}
+		if (oldLevel != _currentLevel) {
+			if (_res._isDemo) {
+				_currentLevel = oldLevel;
+			}
+			changeLevel();
+			_pge_opTempVar1 = 0;
+			return;
 		}
-		changeLevel();
-		_pge_opTempVar1 = 0;
-		return;
 	}
 	if (_loadMap) {
 		if (_currentRoom == 0xFF) {
 			_cut._id = 6;
 			_deathCutsceneCounter = 1;
 		} else {
-			_currentRoom = _pgeLive[0].room_location;
+			_currentRoom = _pgeHot.room_location[0];
 			loadLevelMap();
 			_loadMap = false;
 			_vid.fullRefresh();
 		}
 	}
+	markPerfPhase(PerfStats::PHASE_LOGIC, &phaseTime);
 	prepareAnims();
 	drawAnims();
 	drawCurrentInventoryItem();
@@ -279,8 +353,15 @@ void Game::mainLoop() {
 	if (_blinkingConradCounter != 0) {
 		--_blinkingConradCounter;
 	}
+	markPerfPhase(PerfStats::PHASE_DRAW, &phaseTime);
 	_vid.updateScreen();
+	if (!_firstFramePresented) {
+		markStartupEvent("first frame");
+		_firstFramePresented = true;
+	}
+	markPerfPhase(PerfStats::PHASE_PRESENT, &phaseTime);
 	updateTiming();
+	markPerfPhase(PerfStats::PHASE_WAIT, &phaseTime);
 	drawStoryTexts();
 	if (_stub->_pi.backspace) {
 		_stub->_pi.backspace = false;
@@ -288,23 +369,218 @@ void Game::mainLoop() {
 	}
 	if (_stub->_pi.escape) {
 		_stub->_pi.escape = false;
-		if (handleConfigPanel()) {
+		// escape is not part of the recorded inputs, the panel would read or write the stream
+		if (_recordFile || _demoBin != -1) {
+			debug(DBG_INFO, "The options panel is disabled when recording or replaying inputs");
+		} else if (handleConfigPanel()) {
 			_endLoop = true;
 			return;
 		}
 	}
 	inp_handleSpecialKeys();
+	markPerfPhase(PerfStats::PHASE_MISC, &phaseTime);
+	_stub->_perf.bankHits = _res._bankHits;
+	_stub->_perf.bankMisses = _res._bankMisses;
+}
+
+void Game::markPerfPhase(int phase, uint64_t *t) {
+	const uint64_t now = getTimeNs();
+	_stub->_perf.phaseTime[phase] = (now - *t) / 1000;
+	*t = now;
 }
 
 void Game::updateTiming() {
-	static const int frameHz = 30;
-	int32_t delay = _stub->getTimeStamp() - _frameTimestamp;
-	int32_t pause = (_stub->_pi.dbgMask & PlayerInput::DF_FASTMODE) ? 20 : (1000 / frameHz);
-	pause -= delay;
-	if (pause > 0) {
-		_stub->sleep(pause);
-	}
-	_frameTimestamp = _stub->getTimeStamp();
+	static const int kFrameHz = 30;
+	if (_stub->_pi.dbgMask & PlayerInput::DF_FASTMODE) {
+		_stub->_scheduler.waitMs(20);
+	} else {
+		_stub->_scheduler.wait(1000000000 / kFrameHz);
+	}
+}
+
+void Game::initCapture() {
+	_capture = new VideoCapture;
+	const VideoCapture::Format format = _captureDelta ? VideoCapture::kFormatDelta : VideoCapture::kFormatY4M;
+	if (!_capture->init(_capturePath, format, _vid._w, _vid._h, _mix.getSampleRate())) {
+		delete _capture;
+		_capture = 0;
+		return;
+	}
+	_stub->_capture = _capture;
+	_mix.setCapture(_capture);
+}
+
+void Game::finiCapture() {
+	if (_capture) {
+		_mix.setCapture(0);
+		_stub->_capture = 0;
+		_capture->fini();
+		delete _capture;
+		_capture = 0;
+	}
+}
+
+void Game::loadGlobalBanks() {
+	// not needed by the intro cutscenes and the title screen, loaded with the startup tasks
+	switch (_res._type) {
+	case kResourceTypeAmiga:
+		_res.load("ICONE", Resource::OT_ICN, "SPR");
+		_res.load("ICON", Resource::OT_ICN, "SPR");
+		_res.load("PERSO", Resource::OT_SPM);
+		break;
+	case kResourceTypeDOS:
+		_res.load("GLOBAL", Resource::OT_ICN);
+		_res.load("GLOBAL", Resource::OT_SPC);
+		_res.load("PERSO", Resource::OT_SPR);
+		_res.load_SPR_OFF("PERSO", _res._spr1);
+		_res.load_FIB("GLOBAL");
+		break;
+	}
+	markStartupEvent("global banks");
+}
+
+void Game::markStartupEvent(const char *name) {
+	if (!_firstFramePresented && _startupEventsCount < kStartupEventsMax) {
+		StartupEvent *e = &_startupEvents[_startupEventsCount++];
+		e->name = name;
+		e->time = getTimeNs();
+	}
+}
+
+void Game::printStartupTimeline() {
+	printf("Startup timeline:\n");
+	uint64_t prevTime = _startupTime;
+	for (int i = 0; i < _startupEventsCount; ++i) {
+		const StartupEvent *e = &_startupEvents[i];
+		printf("  %10.3f ms %10.3f ms  %s\n", (e->time - _startupTime) / 1000000., (e->time - prevTime) / 1000000., e->name);
+		prevTime = e->time;
+	}
+}
+
+void Game::printBenchmark() {
+	const uint64_t totalTime = getTimeNs() - _benchStartTime;
+	printf("Benchmark level %d: %u frames in %.3f ms (%.1f fps)\n", _currentLevel, _benchFrames, totalTime / 1000000., totalTime ? _benchFrames * 1000000000. / totalTime : 0.);
+	printf("  pge_process: %u calls in %.3f ms (%.1f ns/call, %.0f calls/s, %.1f per frame)\n", _benchPgeCount, _benchPgeTime / 1000000.,
+		_benchPgeCount ? (double)_benchPgeTime / _benchPgeCount : 0., _benchPgeTime ? _benchPgeCount * 1000000000. / _benchPgeTime : 0.,
+		_benchFrames ? (double)_benchPgeCount / _benchFrames : 0.);
+	printf("  collision: %.3f ms (%.1f ns/frame)\n", _benchColTime / 1000000., _benchFrames ? (double)_benchColTime / _benchFrames : 0.);
+	if (_rewindState) {
+		printf("  rewind: %d frames, %d keyframes, %.1f KB, %.1f us/frame\n", _rewind._count, _rewind._keyframesCount,
+			_rewind._dataSize / 1024., _rewindFrames ? _rewindTime / 1000. / _rewindFrames : 0.);
+	}
+}
+
+void Game::benchmarkCollision() {
+	// crowded room case, every PGE of the level is inserted in the collision grid (this alters the game state)
+	static const int kIterations = 10000;
+	const uint64_t t = getTimeNs();
+	for (int n = 0; n < kIterations; ++n) {
+		col_clearState();
+		for (uint16_t i = 0; i < _res._pgeNum; ++i) {
+			col_preparePiegeState(&_pgeLive[i]);
+		}
+		col_prepareRoomState();
+	}
+	const uint64_t duration = getTimeNs() - t;
+	printf("  crowded collision: %d pieges, %d slots, %.1f ns/frame\n", _res._pgeNum, _col_curPos, (double)duration / kIterations);
+}
+
+struct ProfileEntry {
+	int level, room, num;
+	OpcodeStats stats;
+};
+
+static int compareProfileEntry(const void *a, const void *b) {
+	const uint64_t ta = ((const ProfileEntry *)a)->stats.time;
+	const uint64_t tb = ((const ProfileEntry *)b)->stats.time;
+	return (ta < tb) ? 1 : ((ta > tb) ? -1 : 0);
+}
+
+static void printProfileEntry(const ProfileEntry *e, const char *name, uint64_t totalTime) {
+	const OpcodeStats *s = &e->stats;
+	printf("  0x%02X %-32s %10u %6.1f%% %10.3f %8.1f %6.2f%%\n", e->num, name ? name : "?", s->calls, s->success * 100. / s->calls,
+		s->time / 1000000., (double)s->time / s->calls, totalTime ? s->time * 100. / totalTime : 0.);
+}
+
+void Game::printProfile() {
+	static const int kMaxRoomEntries = 50;
+	ProfileEntry *totals = (ProfileEntry *)calloc(_pge_opcodeTableSize, sizeof(ProfileEntry));
+	if (!totals) {
+		warning("Unable to allocate profile totals");
+		return;
+	}
+	int count = 0;
+	uint64_t totalTime = 0;
+	for (int level = 0; level < kProfileLevels; ++level) {
+		for (int room = 0; room < 256; ++room) {
+			const OpcodeStats *stats = _profileStats[level][room];
+			if (!stats) {
+				continue;
+			}
+			for (int num = 0; num < _pge_opcodeTableSize; ++num) {
+				if (stats[num].calls != 0) {
+					OpcodeStats *s = &totals[num].stats;
+					s->calls += stats[num].calls;
+					s->success += stats[num].success;
+					s->time += stats[num].time;
+					totalTime += stats[num].time;
+					++count;
+				}
+			}
+		}
+	}
+	ProfileEntry *entries = (ProfileEntry *)malloc(MAX(count, 1) * sizeof(ProfileEntry));
+	if (!entries) {
+		warning("Unable to allocate %d profile entries", count);
+		free(totals);
+		return;
+	}
+	count = 0;
+	for (int level = 0; level < kProfileLevels; ++level) {
+		for (int room = 0; room < 256; ++room) {
+			const OpcodeStats *stats = _profileStats[level][room];
+			if (!stats) {
+				continue;
+			}
+			for (int num = 0; num < _pge_opcodeTableSize; ++num) {
+				if (stats[num].calls != 0) {
+					ProfileEntry *e = &entries[count++];
+					e->level = level;
+					e->room = room;
+					e->num = num;
+					e->stats = stats[num];
+				}
+			}
+		}
+	}
+	for (int num = 0; num < _pge_opcodeTableSize; ++num) {
+		totals[num].num = num;
+	}
+	qsort(totals, _pge_opcodeTableSize, sizeof(ProfileEntry), compareProfileEntry);
+	qsort(entries, count, sizeof(ProfileEntry), compareProfileEntry);
+
+	printf("PGE opcodes profile, %.3f ms total\n", totalTime / 1000000.);
+	printf("  num  name                                  calls  success    time ms  ns/call   share\n");
+	for (int i = 0; i < _pge_opcodeTableSize && totals[i].stats.calls != 0; ++i) {
+		printProfileEntry(&totals[i], _pge_opcodeNames[totals[i].num], totalTime);
+	}
+	printf("PGE opcodes profile by level and room, top %d\n", kMaxRoomEntries);
+	printf("  level room num  name                                  calls  success    time ms  ns/call   share\n");
+	for (int i = 0; i < count && i < kMaxRoomEntries; ++i) {
+		printf("  %5d %4d", entries[i].level, entries[i].room);
+		printProfileEntry(&entries[i], _pge_opcodeNames[entries[i].num], totalTime);
+	}
+	free(entries);
+	free(totals);
+}
+
+void Game::freeProfile() {
+	for (int level = 0; level < kProfileLevels; ++level) {
+		for (int room = 0; room < 256; ++room) {
+			free(_profileStats[level][room]);
+			_profileStats[level][room] = 0;
+		}
+	}
 }
 
 void Game::playCutscene(int id) {
@@ -394,6 +670,12 @@ void Game::inp_handleSpecialKeys() {
 	if (_stub->_pi.dbgMask & PlayerInput::DF_SETLIFE) {
 		_pgeLive[0].life = 0x7FFF;
 	}
+	// the recorded inputs do not include the game state changes made outside of the game logic
+	const bool inputsStream = (_recordFile != 0 || _demoBin != -1);
+	if (inputsStream && (_stub->_pi.load || _stub->_pi.save)) {
+		debug(DBG_INFO, "Game states and rewind are disabled when recording or replaying inputs");
+		_stub->_pi.load = _stub->_pi.save = false;
+	}
 	if (_stub->_pi.load) {
 		loadGameState(_stateSlot);
 		_stub->_pi.load = false;
@@ -402,6 +684,7 @@ void Game::inp_handleSpecialKeys() {
 		saveGameState(_stateSlot);
 		_stub->_pi.save = false;
 	}
+	checkSavedGameStates();
 	if (_stub->_pi.stateSlot != 0) {
 		int8_t slot = _stateSlot + _stub->_pi.stateSlot;
 		if (slot >= 1 && slot < 100) {
@@ -410,6 +693,22 @@ void Game::inp_handleSpecialKeys() {
 		}
 		_stub->_pi.stateSlot = 0;
 	}
+	if (_rewindState && !inputsStream) {
+		if (_stub->_pi.rewind) {
+			if (!_rewinding) {
+				printRewindStats();
+				_rewinding = true;
+			}
+			if (_rewind.pop((uint8_t *)_rewindState)) {
+				restoreSnapshot(_rewindState);
+			}
+		} else if (_rewinding) {
+			// the restored state is already the last frame of the buffer
+			_rewinding = false;
+		} else {
+			pushRewindFrame();
+		}
+	}
 }
 
 void Game::drawCurrentInventoryItem() {
@@ -435,7 +734,7 @@ void Game::showFinalScore() {
 			_stub->_pi.enter = false;
 			break;
 		}
-		_stub->sleep(100);
+		_stub->_scheduler.waitMs(100);
 	}
 }
 
@@ -491,7 +790,7 @@ bool Game::handleConfigPanel() {
 		_menu.drawString(buf, y + 10, 9, 1);
 
 		_vid.updateScreen();
-		_stub->sleep(80);
+		_stub->_scheduler.waitMs(80);
 		inp_update();
 
 		int prev = current;
@@ -550,7 +849,13 @@ bool Game::handleContinueAbort() {
 	Color col;
 	_stub->getPaletteEntry(0xE4, &col);
 	memcpy(_vid._tempLayer, _vid._frontLayer, _vid._layerSize);
+	int drawn_time = -1;
+	int drawn_color = -1;
 	while (timeout >= 0 && !_stub->_pi.quit) {
+		// the screen is copied when the texts change, the color cycling is a palette update
+		const bool redraw = (timeout / 10 != drawn_time || current_color != drawn_color);
+		drawn_time = timeout / 10;
+		drawn_color = current_color;
 		const char *str;
 		str = _res.getMenuString(LocaleData::LI_01_CONTINUE_OR_ABORT);
 		_vid.drawString(str, (256 - strlen(str) * 8) / 2, 64, 0xE3);
@@ -582,7 +887,9 @@ bool Game::handleContinueAbort() {
 			_stub->_pi.enter = false;
 			return (current_color == 0);
 		}
-		_stub->copyRect(0, 0, _vid._w, _vid._h, _vid._frontLayer, 256);
+		if (redraw) {
+			_stub->copyRect(0, 0, _vid._w, _vid._h, _vid._frontLayer, 256);
+		}
 		_stub->updateScreen(0);
 		static const int COLOR_STEP = 8;
 		static const int COLOR_MIN = 16;
@@ -600,8 +907,13 @@ bool Game::handleContinueAbort() {
 			col.g -= COLOR_STEP;
 		}
 		_stub->setPaletteEntry(0xE4, &col);
-		_stub->processEvents();
-		_stub->sleep(100);
+		if (_recordFile || _demoBin == kDemoReplay) {
+			// the choice is part of the recorded inputs
+			inp_update();
+		} else {
+			_stub->processEvents();
+		}
+		_stub->_scheduler.waitMs(100);
 		--timeout;
 		memcpy(_vid._frontLayer, _vid._tempLayer, _vid._layerSize);
 	}
@@ -627,7 +939,7 @@ bool Game::handleProtectionScreen() {
 		_cut.drawProtectionShape(shapeNum, zoom);
 		_stub->copyRect(0, 0, _vid._w, _vid._h, _vid._tempLayer, 256);
 		_stub->updateScreen(0);
-		_stub->sleep(30);
+		_stub->_scheduler.waitMs(30);
 	}
 	int codeNum = getRandomNumber() % 5;
 	_cut.drawProtectionShape(shapeNum, 1);
@@ -642,7 +954,7 @@ bool Game::handleProtectionScreen() {
 		snprintf(buf, sizeof(buf), "CODE %d :  %s", codeNum + 1, codeText);
 		_vid.drawString(buf, 8 * 8, 23 * 8, _menu._charVar2);
 		_vid.updateScreen();
-		_stub->sleep(50);
+		_stub->_scheduler.waitMs(50);
 		_stub->processEvents();
 		char c = _stub->_pi.lastChar;
 		if (c != 0) {
@@ -773,7 +1085,7 @@ void Game::drawStoryTexts() {
 					break;
 				}
 				inp_update();
-				_stub->sleep(80);
+				_stub->_scheduler.waitMs(80);
 			}
 			if (chunk.data) {
 				_mix.stopAll();
@@ -802,7 +1114,7 @@ void Game::prepareAnims() {
 		if (pge_room >= 0 && pge_room < 0x40) {
 			pge = _pge_liveTable1[pge_room];
 			while (pge) {
-				if ((pge->init_PGE->object_type != 10 && pge->pos_y > 176) || (pge->init_PGE->object_type == 10 && pge->pos_y > 216)) {
+				if ((pge->init_PGE->object_type != 10 && pge_posY(pge) > 176) || (pge->init_PGE->object_type == 10 && pge_posY(pge) > 216)) {
 					prepareAnimsHelper(pge, 0, -216);
 				}
 				pge = pge->next_PGE_in_room;
@@ -812,7 +1124,7 @@ void Game::prepareAnims() {
 		if (pge_room >= 0 && pge_room < 0x40) {
 			pge = _pge_liveTable1[pge_room];
 			while (pge) {
-				if (pge->pos_y < 48) {
+				if (pge_posY(pge) < 48) {
 					prepareAnimsHelper(pge, 0, 216);
 				}
 				pge = pge->next_PGE_in_room;
@@ -822,7 +1134,7 @@ void Game::prepareAnims() {
 		if (pge_room >= 0 && pge_room < 0x40) {
 			pge = _pge_liveTable1[pge_room];
 			while (pge) {
-				if (pge->pos_x > 224) {
+				if (pge_posX(pge) > 224) {
 					prepareAnimsHelper(pge, -256, 0);
 				}
 				pge = pge->next_PGE_in_room;
@@ -832,7 +1144,7 @@ void Game::prepareAnims() {
 		if (pge_room >= 0 && pge_room < 0x40) {
 			pge = _pge_liveTable1[pge_room];
 			while (pge) {
-				if (pge->pos_x <= 32) {
+				if (pge_posX(pge) <= 32) {
 					prepareAnimsHelper(pge, 256, 0);
 				}
 				pge = pge->next_PGE_in_room;
@@ -842,8 +1154,8 @@ void Game::prepareAnims() {
 }
 
 void Game::prepareAnimsHelper(LivePGE *pge, int16_t dx, int16_t dy) {
-	debug(DBG_GAME, "Game::prepareAnimsHelper() dx=0x%X dy=0x%X pge_num=%ld pge->flags=0x%X pge->anim_number=0x%X", dx, dy, pge - &_pgeLive[0], pge->flags, pge->anim_number);
-	if (!(pge->flags & 8)) {
+	debug(DBG_GAME, "Game::prepareAnimsHelper() dx=0x%X dy=0x%X pge_num=%ld pge->flags=0x%X pge->anim_number=0x%X", dx, dy, pge - &_pgeLive[0], pge_flags(pge), pge->anim_number);
+	if (!(pge_flags(pge) & 8)) {
 		if (pge->index != 0 && loadMonsterSprites(pge) == 0) {
 			return;
 		}
@@ -866,10 +1178,10 @@ void Game::prepareAnimsHelper(LivePGE *pge, int16_t dx, int16_t dy) {
 			dataPtr += 4;
 			break;
 		}
-		const int16_t ypos = dy + pge->pos_y - dh + 2;
-		int16_t xpos = dx + pge->pos_x - dw;
-		if (pge->flags & 2) {
-			xpos = dw + dx + pge->pos_x;
+		const int16_t ypos = dy + pge_posY(pge) - dh + 2;
+		int16_t xpos = dx + pge_posX(pge) - dw;
+		if (pge_flags(pge) & 2) {
+			xpos = dw + dx + pge_posX(pge);
 			uint8_t _cl = w;
 			if (_cl & 0x40) {
 				_cl = h;
@@ -884,7 +1196,7 @@ void Game::prepareAnimsHelper(LivePGE *pge, int16_t dx, int16_t dy) {
 		xpos += 8;
 		if (pge == &_pgeLive[0]) {
 			_animBuffers.addState(1, xpos, ypos, dataPtr, pge, w, h);
-		} else if (pge->flags & 0x10) {
+		} else if (pge_flags(pge) & 0x10) {
 			_animBuffers.addState(2, xpos, ypos, dataPtr, pge, w, h);
 		} else {
 			_animBuffers.addState(0, xpos, ypos, dataPtr, pge, w, h);
@@ -892,11 +1204,11 @@ void Game::prepareAnimsHelper(LivePGE *pge, int16_t dx, int16_t dy) {
 	} else {
 		assert(pge->anim_number < _res._numSpc);
 		const uint8_t *dataPtr = _res._spc + READ_BE_UINT16(_res._spc + pge->anim_number * 2);
-		const int16_t xpos = dx + pge->pos_x + 8;
-		const int16_t ypos = dy + pge->pos_y + 2;
+		const int16_t xpos = dx + pge_posX(pge) + 8;
+		const int16_t ypos = dy + pge_posY(pge) + 2;
 		if (pge->init_PGE->object_type == 11) {
 			_animBuffers.addState(3, xpos, ypos, dataPtr, pge);
-		} else if (pge->flags & 0x10) {
+		} else if (pge_flags(pge) & 0x10) {
 			_animBuffers.addState(2, xpos, ypos, dataPtr, pge);
 		} else {
 			_animBuffers.addState(0, xpos, ypos, dataPtr, pge);
@@ -925,26 +1237,26 @@ void Game::drawAnimBuffer(uint8_t stateNum, AnimBufferState *state) {
 		_animBuffers._curPos[stateNum] = 0xFF;
 		do {
 			LivePGE *pge = state->pge;
-			if (!(pge->flags & 8)) {
+			if (!(pge_flags(pge) & 8)) {
 				if (stateNum == 1 && (_blinkingConradCounter & 1)) {
 					break;
 				}
 				switch (_res._type) {
 				case kResourceTypeAmiga:
 					_vid.AMIGA_decodeSpm(state->dataPtr, _res._memBuf);
-					drawCharacter(_res._memBuf, state->x, state->y, state->h, state->w, pge->flags);
+					drawCharacter(_res._memBuf, state->x, state->y, state->h, state->w, pge_flags(pge));
 					break;
 				case kResourceTypeDOS:
 					if (!(state->dataPtr[-2] & 0x80)) {
 						decodeCharacterFrame(state->dataPtr, _res._memBuf);
-						drawCharacter(_res._memBuf, state->x, state->y, state->h, state->w, pge->flags);
+						drawCharacter(_res._memBuf, state->x, state->y, state->h, state->w, pge_flags(pge));
 					} else {
-						drawCharacter(state->dataPtr, state->x, state->y, state->h, state->w, pge->flags);
+						drawCharacter(state->dataPtr, state->x, state->y, state->h, state->w, pge_flags(pge));
 					}
 					break;
 				}
 			} else {
-				drawObject(state->dataPtr, state->x, state->y, pge->flags);
+				drawObject(state->dataPtr, state->x, state->y, pge_flags(pge));
 			}
 			--state;
 		} while (--numAnims != 0);
@@ -1227,7 +1539,7 @@ int Game::loadMonsterSprites(LivePGE *pge) {
 	if (init_pge->obj_node_number == _curMonsterFrame) {
 		return 0xFFFF;
 	}
-	if (pge->room_location != _currentRoom) {
+	if (pge_roomLocation(pge) != _currentRoom) {
 		return 0;
 	}
 
@@ -1360,7 +1672,7 @@ void Game::loadLevelData() {
 		_res.load(lvl->name, Resource::OT_CT);
 		_res.load(lvl->name, Resource::OT_PAL);
 		_res.load(lvl->name, Resource::OT_RP);
-		if (_res._isDemo || g_options.use_tiledata) { // use .BNQ/.LEV/(.SGD) instead of .MAP (PC demo)
+		if (_res._isDemo || _options.use_tiledata) { // use .BNQ/.LEV/(.SGD) instead of .MAP (PC demo)
 			if (_currentLevel == 0) {
 				_res.load(lvl->name, Resource::OT_SGD);
 			}
@@ -1376,6 +1688,8 @@ void Game::loadLevelData() {
 		break;
 	}
 
+	pge_resolveOpcodes();
+
 	_cut._id = lvl->cutscene_id;
 	if (_res._isDemo && _currentLevel == 5) { // PC demo does not include TELEPORT.*
 		_cut._id = 0xFFFF;
@@ -1390,8 +1704,12 @@ void Game::loadLevelData() {
 	_col_slots2Cur = _col_slots2;
 	_col_slots2Next = 0;
 
-	memset(_pge_liveTable2, 0, sizeof(_pge_liveTable2));
+	pge_clearActive();
 	memset(_pge_liveTable1, 0, sizeof(_pge_liveTable1));
+	// states of the previous level cannot be rewound to
+	if (_rewindState) {
+		_rewind.clear();
+	}
 
 	_currentRoom = _res._pgeInit[0].init_room;
 	uint16_t n = _res._pgeNum;
@@ -1399,12 +1717,15 @@ void Game::loadLevelData() {
 		pge_loadForCurrentLevel(n);
 	}
 
-	if (_demoBin != -1) {
+	// the recorded inputs only start from the header position on the first load, the restarts
+	// after a death or a level change follow the inputs
+	if (_demoBin != -1 && (_demoBin != kDemoReplay || _demoStart)) {
+		_demoStart = false;
 		_cut._id = -1;
-		if (_demoInputs[_demoBin].room != 255) {
-			_pgeLive[0].room_location = _demoInputs[_demoBin].room;
-			_pgeLive[0].pos_x = _demoInputs[_demoBin].x;
-			_pgeLive[0].pos_y = _demoInputs[_demoBin].y;
+		if (_demo.room != 255) {
+			_pgeHot.room_location[0] = _demo.room;
+			_pgeHot.pos_x[0] = _demo.x;
+			_pgeHot.pos_y[0] = _demo.y;
 		} else {
 			_inp_demPos = 1;
 		}
@@ -1413,8 +1734,8 @@ void Game::loadLevelData() {
 	for (uint16_t i = 0; i < _res._pgeNum; ++i) {
 		if (_res._pgeInit[i].skill <= _skillLevel) {
 			LivePGE *pge = &_pgeLive[i];
-			pge->next_PGE_in_room = _pge_liveTable1[pge->room_location];
-			_pge_liveTable1[pge->room_location] = pge;
+			pge->next_PGE_in_room = _pge_liveTable1[pge_roomLocation(pge)];
+			_pge_liveTable1[pge_roomLocation(pge)] = pge;
 		}
 	}
 	pge_resetGroups();
@@ -1487,7 +1808,16 @@ uint16_t Game::getRandomNumber() {
 }
 
 void Game::changeLevel() {
-	_vid.fadeOut();
+	if (_options.fade_out_palette) {
+		_vid.startPaletteFade();
+		_levelChangePending = true;
+	} else {
+		_vid.fadeOut();
+		loadNextLevel();
+	}
+}
+
+void Game::loadNextLevel() {
 	loadLevelData();
 	loadLevelMap();
 	_vid.setPalette0xF();
@@ -1591,7 +1921,7 @@ void Game::handleInventory() {
 			}
 
 			_vid.updateScreen();
-			_stub->sleep(80);
+			_stub->_scheduler.waitMs(80);
 			inp_update();
 
 			if (_stub->_pi.dirMask & PlayerInput::DIR_UP) {
@@ -1649,9 +1979,106 @@ void Game::inp_update() {
 		_stub->_pi.space = (keymask & 0x20) != 0;
 		_stub->_pi.shift = (keymask & 0x40) != 0;
 		_stub->_pi.backspace = (keymask & 0x80) != 0;
+	} else if (_recordFile) {
+		uint8_t keymask = _stub->_pi.dirMask;
+		if (_stub->_pi.enter) {
+			keymask |= 0x10;
+		}
+		if (_stub->_pi.space) {
+			keymask |= 0x20;
+		}
+		if (_stub->_pi.shift) {
+			keymask |= 0x40;
+		}
+		if (_stub->_pi.backspace) {
+			keymask |= 0x80;
+		}
+		fputc(keymask, _recordFile);
+		++_inp_demPos; // same game state as when replaying
 	}
 }
 
+// recorded inputs file : header followed by the key masks read by inp_update, one byte per call
+
+static const uint32_t TAG_FBIN = 0x4642494E;
+
+static void writeUint32BE(FILE *fp, uint32_t n) {
+	fputc(n >> 24, fp);
+	fputc((n >> 16) & 255, fp);
+	fputc((n >> 8) & 255, fp);
+	fputc(n & 255, fp);
+}
+
+static uint32_t readUint32BE(FILE *fp) {
+	uint8_t buf[4];
+	if (fread(buf, 1, sizeof(buf), fp) != sizeof(buf)) {
+		return 0;
+	}
+	return READ_BE_UINT32(buf);
+}
+
+void Game::inp_startRecording(uint32_t seed) {
+	_recordFile = fopen(_recordPath, "wb");
+	if (!_recordFile) {
+		warning("Unable to open '%s' for recording", _recordPath);
+	} else {
+		debug(DBG_INFO, "Recording inputs to '%s'", _recordPath);
+		writeUint32BE(_recordFile, TAG_FBIN);
+		fputc(1, _recordFile); // version
+		fputc(_currentLevel, _recordFile);
+		fputc(_skillLevel, _recordFile);
+		fputc(_pgeHot.room_location[0], _recordFile);
+		writeUint32BE(_recordFile, _pgeHot.pos_x[0]);
+		writeUint32BE(_recordFile, _pgeHot.pos_y[0]);
+		writeUint32BE(_recordFile, seed);
+	}
+	// a single recording per session
+	_recordPath = 0;
+}
+
+void Game::inp_stopRecording() {
+	if (ferror(_recordFile)) {
+		warning("I/O error when recording inputs");
+	}
+	fclose(_recordFile);
+	_recordFile = 0;
+}
+
+bool Game::inp_loadRecording(const char *path) {
+	FILE *fp = fopen(path, "rb");
+	if (!fp) {
+		warning("Unable to open recorded inputs '%s'", path);
+		return false;
+	}
+	bool ret = false;
+	if (readUint32BE(fp) != TAG_FBIN || fgetc(fp) != 1) {
+		warning("Bad recorded inputs format");
+	} else {
+		_demo.name = path;
+		_demo.level = fgetc(fp);
+		_skillLevel = fgetc(fp);
+		_demo.room = fgetc(fp);
+		_demo.x = (int16_t)readUint32BE(fp);
+		_demo.y = (int16_t)readUint32BE(fp);
+		_demoSeed = readUint32BE(fp);
+		const long pos = ftell(fp);
+		fseek(fp, 0, SEEK_END);
+		const int len = ftell(fp) - pos;
+		fseek(fp, pos, SEEK_SET);
+		free(_res._dem);
+		_res._dem = (len > 0) ? (uint8_t *)malloc(len) : 0;
+		if (_res._dem && fread(_res._dem, 1, len, fp) == (size_t)len) {
+			_res._demLen = len;
+			debug(DBG_INFO, "Loaded %d recorded inputs from '%s' (level %d room %d)", len, path, _demo.level + 1, _demo.room);
+			ret = true;
+		} else {
+			warning("Unable to read recorded inputs");
+		}
+	}
+	fclose(fp);
+	return ret;
+}
+
 void Game::makeGameStateName(uint8_t slot, char *buf) {
 	sprintf(buf, "rs-level%d-%02d.state", _currentLevel + 1, slot);
 }
@@ -1662,33 +2089,46 @@ bool Game::saveGameState(uint8_t slot) {
 	bool success = false;
 	char stateFile[20];
 	makeGameStateName(slot, stateFile);
+	// serialise in memory, the state writer thread compresses and writes the file
 	File f;
-	if (!f.open(stateFile, "zwb", _savePath)) {
-		warning("Unable to save state file '%s'", stateFile);
+	f.openMemory();
+	// header
+	f.writeUint32BE(TAG_FBSV);
+	f.writeUint16BE(2);
+	char buf[32];
+	memset(buf, 0, sizeof(buf));
+	snprintf(buf, sizeof(buf), "level=%d room=%d", _currentLevel + 1, _currentRoom);
+	f.write(buf, sizeof(buf));
+	// contents
+	saveState(&f);
+	if (f.ioErr()) {
+		warning("Unable to serialise game state");
 	} else {
-		// header
-		f.writeUint32BE(TAG_FBSV);
-		f.writeUint16BE(2);
-		char buf[32];
-		memset(buf, 0, sizeof(buf));
-		snprintf(buf, sizeof(buf), "level=%d room=%d", _currentLevel + 1, _currentRoom);
-		f.write(buf, sizeof(buf));
-		// contents
-		saveState(&f);
-		if (f.ioErr()) {
-			warning("I/O error when saving game state");
-		} else {
+		uint32_t size;
+		uint8_t *data = f.releaseMemoryBuffer(&size);
+		_stateWriter.queue(stateFile, _savePath, slot, data, size);
+		success = true;
+	}
+	return success;
+}
+
+void Game::checkSavedGameStates() {
+	int slot;
+	bool success;
+	while (_stateWriter.getCompleted(&slot, &success)) {
+		if (success) {
 			debug(DBG_INFO, "Saved state to slot %d", slot);
-			success = true;
+		} else if (slot == 0) {
+			_validSaveState = false;
 		}
 	}
-	return success;
 }
 
 bool Game::loadGameState(uint8_t slot) {
 	bool success = false;
 	char stateFile[20];
 	makeGameStateName(slot, stateFile);
+	_stateWriter.wait(stateFile);
 	File f;
 	if (!f.open(stateFile, "zrb", _savePath)) {
 		warning("Unable to open state file '%s'", stateFile);
@@ -1733,11 +2173,11 @@ void Game::saveState(File *f) {
 	}
 	for (int i = 0; i < _res._pgeNum; ++i) {
 		LivePGE *pge = &_pgeLive[i];
-		f->writeUint16BE(pge->obj_type);
-		f->writeUint16BE(pge->pos_x);
-		f->writeUint16BE(pge->pos_y);
-		f->writeByte(pge->anim_seq);
-		f->writeByte(pge->room_location);
+		f->writeUint16BE(pge_objType(pge));
+		f->writeUint16BE(pge_posX(pge));
+		f->writeUint16BE(pge_posY(pge));
+		f->writeByte(pge_animSeq(pge));
+		f->writeByte(pge_roomLocation(pge));
 		f->writeUint16BE(pge->life);
 		f->writeUint16BE(pge->counter_value);
 		f->writeByte(pge->collision_slot);
@@ -1745,7 +2185,7 @@ void Game::saveState(File *f) {
 		f->writeByte(pge->current_inventory_PGE);
 		f->writeByte(pge->unkF);
 		f->writeUint16BE(pge->anim_number);
-		f->writeByte(pge->flags);
+		f->writeByte(pge_flags(pge));
 		f->writeByte(pge->index);
 		f->writeUint16BE(pge->first_obj_number);
 		if (pge->next_PGE_in_room == 0) {
@@ -1781,7 +2221,7 @@ void Game::loadState(File *f) {
 	uint32_t off;
 	_skillLevel = f->readByte();
 	_score = f->readUint32BE();
-	memset(_pge_liveTable2, 0, sizeof(_pge_liveTable2));
+	pge_clearActive();
 	memset(_pge_liveTable1, 0, sizeof(_pge_liveTable1));
 	off = f->readUint32BE();
 	if (off == 0xFFFFFFFF) {
@@ -1797,11 +2237,11 @@ void Game::loadState(File *f) {
 	}
 	for (i = 0; i < _res._pgeNum; ++i) {
 		LivePGE *pge = &_pgeLive[i];
-		pge->obj_type = f->readUint16BE();
-		pge->pos_x = f->readUint16BE();
-		pge->pos_y = f->readUint16BE();
-		pge->anim_seq = f->readByte();
-		pge->room_location = f->readByte();
+		pge_objType(pge) = f->readUint16BE();
+		pge_posX(pge) = f->readUint16BE();
+		pge_posY(pge) = f->readUint16BE();
+		pge_animSeq(pge) = f->readByte();
+		pge_roomLocation(pge) = f->readByte();
 		pge->life = f->readUint16BE();
 		pge->counter_value = f->readUint16BE();
 		pge->collision_slot = f->readByte();
@@ -1809,7 +2249,7 @@ void Game::loadState(File *f) {
 		pge->current_inventory_PGE = f->readByte();
 		pge->unkF = f->readByte();
 		pge->anim_number = f->readUint16BE();
-		pge->flags = f->readByte();
+		pge_flags(pge) = f->readByte();
 		pge->index = f->readByte();
 		pge->first_obj_number = f->readUint16BE();
 		off = f->readUint32BE();
@@ -1845,11 +2285,11 @@ void Game::loadState(File *f) {
 	for (i = 0; i < _res._pgeNum; ++i) {
 		if (_res._pgeInit[i].skill <= _skillLevel) {
 			LivePGE *pge = &_pgeLive[i];
-			if (pge->flags & 4) {
-				_pge_liveTable2[pge->index] = pge;
+			if (pge_flags(pge) & 4) {
+				pge_activate(pge);
 			}
-			pge->next_PGE_in_room = _pge_liveTable1[pge->room_location];
-			_pge_liveTable1[pge->room_location] = pge;
+			pge->next_PGE_in_room = _pge_liveTable1[pge_roomLocation(pge)];
+			_pge_liveTable1[pge_roomLocation(pge)] = pge;
 		}
 	}
 	resetGameState();
@@ -12,12 +12,72 @@
 #include "menu.h"
 #include "mixer.h"
 #include "resource.h"
+#include "rewind.h"
 #include "seq_player.h"
+#include "state_writer.h"
 #include "video.h"
 
 struct File;
 struct FileSystem;
 struct SystemStub;
+struct VideoCapture;
+
+// simulation state, pointers are stored as indexes (see snapshot.cpp)
+struct GameSnapshot {
+	uint8_t currentLevel;
+	uint8_t skillLevel;
+	uint32_t score;
+	uint8_t currentRoom;
+	uint8_t currentIcon;
+	bool loadMap;
+	uint8_t printLevelCodeCounter;
+	uint32_t randSeed;
+	uint16_t currentInventoryIconNum;
+	uint8_t blinkingConradCounter;
+	uint16_t textToDisplay;
+	bool eraseBackground;
+	uint16_t deathCutsceneCounter;
+	bool saveStateCompleted;
+	bool validSaveState;
+	uint16_t cutId;
+	uint16_t deathCutsceneId;
+	uint8_t animBuffersPos[4];
+
+	bool pgePlayAnimSound;
+	uint8_t pgeCurrentPiegeRoom;
+	bool pgeCurrentPiegeFacingDir;
+	bool pgeProcessOBJ;
+	uint8_t pgeInpKeysMask;
+	uint16_t pgeOpTempVar1;
+	uint16_t pgeOpTempVar2;
+	uint16_t pgeCompareVar1;
+	uint16_t pgeCompareVar2;
+	LivePGE pgeLive[256];
+	LivePGEHot pgeHot;
+	uint32_t pgeActiveMask[256 / 32];
+	LivePGE *pgeLiveTable1[256];
+	GroupPGE pgeGroups[256];
+	GroupPGE *pgeGroupsTable[256];
+	GroupPGE *pgeNextFreeGroup;
+
+	uint8_t colCurPos;
+	CollisionSlot colSlots[256];
+	CollisionSlot *colSlotsTable[256];
+	CollisionSlot *colCurSlot;
+	CollisionSlot2 colSlots2[256];
+	CollisionSlot2 *colSlots2Cur;
+	CollisionSlot2 *colSlots2Next;
+	uint8_t colActiveCollisionSlots[0x30 * 3];
+	uint8_t colCurrentLeftRoom;
+	uint8_t colCurrentRightRoom;
+	int16_t colCurrentPiegeGridPosX;
+	int16_t colCurrentPiegeGridPosY;
+	int8_t ctData[0x1D00];
+
+	uint8_t inpLastKeysHit;
+	uint8_t inpLastKeysHitLeftRight;
+	int inpDemPos;
+};
 
 struct Game {
 	typedef int (Game::*pge_OpcodeProc)(ObjectOpcodeArgs *args);
@@ -32,6 +92,10 @@ struct Game {
 		CT_LEFT_ROOM  = 0xC0
 	};
 
+	enum {
+		kDemoReplay = 100 // _demoBin value when playing inputs recorded with --record
+	};
+
 	static const Demo _demoInputs[3];
 	static const Level _gameLevels[];
 	static const uint16_t _scoreTable[];
@@ -46,10 +110,13 @@ struct Game {
 	static const uint8_t _monsterPals[4][32];
 	static const char *_monsterNames[2][4];
 	static const pge_OpcodeProc _pge_opcodeTable[];
+	static const int _pge_opcodeTableSize;
+	static const char *_pge_opcodeNames[];
 	static const uint8_t _pge_modKeysTable[];
 	static const uint8_t _protectionCodeData[];
 	static const uint8_t _protectionPal[];
 
+	Options _options;
 	Cutscene _cut;
 	Menu _menu;
 	Mixer _mix;
@@ -65,6 +132,9 @@ struct Game {
 	uint8_t _currentLevel;
 	uint8_t _skillLevel;
 	int _demoBin;
+	Demo _demo;
+	uint32_t _demoSeed;
+	bool _demoStart; // the replay start position is not applied yet
 	uint32_t _score;
 	uint8_t _currentRoom;
 	uint8_t _currentIcon;
@@ -85,14 +155,25 @@ struct Game {
 	uint16_t _deathCutsceneCounter;
 	bool _saveStateCompleted;
 	bool _endLoop;
-	uint32_t _frameTimestamp;
+	bool _levelChangePending; // the next level is loaded once the palette fade completes
+	uint32_t _framesCount;
+	bool _globalBanksLoaded;
+	bool _startupParallel;
+	bool _benchmark;
+	uint32_t _benchFrames;
+	uint32_t _benchPgeCount;
+	uint64_t _benchPgeTime;
+	uint64_t _benchColTime;
+	uint64_t _benchStartTime;
 
-	Game(SystemStub *, FileSystem *, const char *savePath, int level, int demo, ResourceType ver, Language lang);
+	Game(SystemStub *, FileSystem *, const char *savePath, int level, int demo, ResourceType ver, Language lang, const Options &options);
 
 	void run();
+	void loadGlobalBanks();
 	void displayTitleScreenAmiga();
 	void resetGameState();
 	void mainLoop();
+	void markPerfPhase(int phase, uint64_t *t);
 	void updateTiming();
 	void playCutscene(int id = -1);
 	bool playCutsceneSeq(const char *name);
@@ -120,8 +201,11 @@ struct Game {
 	void playSound(uint8_t sfxId, uint8_t softVol);
 	uint16_t getRandomNumber();
 	void changeLevel();
+	void loadNextLevel();
 	uint16_t getLineLength(const uint8_t *str) const;
 	void handleInventory();
+	void printBenchmark();
+	void benchmarkCollision();
 
 
 	// pieges
@@ -129,9 +213,10 @@ struct Game {
 	GroupPGE _pge_groups[256];
 	GroupPGE *_pge_groupsTable[256];
 	GroupPGE *_pge_nextFreeGroup;
-	LivePGE *_pge_liveTable2[256]; // active pieges list (index = pge number)
+	uint32_t _pge_activeMask[256 / 32]; // active pieges set (bit = pge number)
 	LivePGE *_pge_liveTable1[256]; // pieges list by room (index = room)
 	LivePGE _pgeLive[256];
+	LivePGEHot _pgeHot;
 	uint8_t _pge_currentPiegeRoom;
 	bool _pge_currentPiegeFacingDir; // (false == left)
 	bool _pge_processOBJ;
@@ -141,16 +226,28 @@ struct Game {
 	uint16_t _pge_compareVar1;
 	uint16_t _pge_compareVar2;
 
+	uint16_t &pge_objType(const LivePGE *pge) { return _pgeHot.obj_type[pge - _pgeLive]; }
+	int16_t &pge_posX(const LivePGE *pge) { return _pgeHot.pos_x[pge - _pgeLive]; }
+	int16_t &pge_posY(const LivePGE *pge) { return _pgeHot.pos_y[pge - _pgeLive]; }
+	uint8_t &pge_animSeq(const LivePGE *pge) { return _pgeHot.anim_seq[pge - _pgeLive]; }
+	uint8_t &pge_roomLocation(const LivePGE *pge) { return _pgeHot.room_location[pge - _pgeLive]; }
+	uint8_t &pge_flags(const LivePGE *pge) { return _pgeHot.flags[pge - _pgeLive]; }
+
 	void pge_resetGroups();
 	void pge_removeFromGroup(uint8_t idx);
 	int pge_isInGroup(LivePGE *pge_dst, uint16_t group_id, uint16_t counter);
 	void pge_loadForCurrentLevel(uint16_t idx);
+	void pge_resolveOpcodes();
 	void pge_process(LivePGE *pge);
 	void pge_setupNextAnimFrame(LivePGE *pge, GroupPGE *le);
 	void pge_playAnimSound(LivePGE *pge, uint16_t arg2);
 	void pge_setupAnim(LivePGE *pge);
-	int pge_execute(LivePGE *live_pge, InitPGE *init_pge, const Object *obj);
+	int pge_execute(LivePGE *live_pge, InitPGE *init_pge, const Object *obj, const ObjectCode *code);
 	void pge_prepare();
+	void pge_clearActive();
+	void pge_activate(LivePGE *pge);
+	void pge_deactivate(LivePGE *pge);
+	int pge_getNextActive(int num) const;
 	void pge_setupDefaultAnim(LivePGE *pge);
 	uint16_t pge_processOBJ(LivePGE *pge);
 	void pge_setupOtherPieges(LivePGE *pge, InitPGE *init_pge);
@@ -315,9 +412,16 @@ struct Game {
 
 
 	// collision
+	enum {
+		kColGridSize = 0x80 * 64 // ct_pos = room * 64 + cell
+	};
+
 	CollisionSlot _col_slots[256];
 	uint8_t _col_curPos;
 	CollisionSlot *_col_slotsTable[256];
+	uint8_t _col_gridSlots[kColGridSize]; // _col_slotsTable index by ct_pos, valid if the epoch matches
+	uint16_t _col_gridEpochs[kColGridSize];
+	uint16_t _col_gridEpoch;
 	CollisionSlot *_col_curSlot;
 	CollisionSlot2 _col_slots2[256];
 	CollisionSlot2 *_col_slots2Cur;
@@ -357,15 +461,95 @@ struct Game {
 
 	void inp_handleSpecialKeys();
 	void inp_update();
+	bool inp_loadRecording(const char *path);
+	void inp_startRecording(uint32_t seed);
+	void inp_stopRecording();
+
+	const char *_recordPath;
+	const char *_replayPath;
+	FILE *_recordFile;
+
+
+	// rewind
+	RewindBuffer _rewind;
+	GameSnapshot *_rewindState;
+	bool _rewinding;
+	uint32_t _rewindFrames;
+	uint64_t _rewindTime;
+
+	void initRewind();
+	void finiRewind();
+	void pushRewindFrame();
+	void printRewindStats();
+
+	// video capture
+	const char *_capturePath;
+	bool _captureDelta;
+	VideoCapture *_capture;
+
+	void initCapture();
+	void finiCapture();
+
+
+	// state hashing
+	enum {
+		kStateHashBufferSize = 32 * 1024
+	};
+
+	const char *_hashTracePath;
+	const char *_hashComparePath;
+	FILE *_hashTraceFile;
+	FILE *_hashCompareFile;
+	uint8_t *_hashState;
+	uint32_t _hashFrame;
+	int _hashDivergedFrame;
+
+	bool initStateHash();
+	void finiStateHash();
+	void hashFrameState();
+	uint64_t hashGameState(uint8_t *buf);
+
+
+	// profiling
+	enum {
+		kProfileLevels = 8,
+		kStartupEventsMax = 16
+	};
+
+	bool _profile;
+	OpcodeStats *_profileStats[kProfileLevels][256]; // allocated on first use (index = level, room)
+
+	int pge_profileOpcode(uint8_t num, ObjectOpcodeArgs *args);
+	void printProfile();
+	void freeProfile();
+
+	uint64_t _startupTime; // set to the process start by main()
+	StartupEvent _startupEvents[kStartupEventsMax];
+	int _startupEventsCount;
+	bool _firstFramePresented;
+
+	void markStartupEvent(const char *name);
+	void printStartupTimeline();
+
+	// startup tasks
+	void startupLoadResources();
+	void startupLoadTexts();
+	void startupInitAudio();
+	void runStartupTasks();
 
 
 	// save/load state
 	uint8_t _stateSlot;
 	bool _validSaveState;
+	StateWriter _stateWriter;
 
+	void saveSnapshot(GameSnapshot *s);
+	void restoreSnapshot(const GameSnapshot *s);
+	void benchmarkSnapshot();
 	void makeGameStateName(uint8_t slot, char *buf);
 	bool saveGameState(uint8_t slot);
 	bool loadGameState(uint8_t slot);
+	void checkSavedGameStates();
 	void saveState(File *f);
 	void loadState(File *f);
 };
@@ -69,6 +69,19 @@ inline void SWAP(T &a, T &b) {
 	b = tmp;
 }
 
+inline int findFirstBitSet(uint32_t mask) { // mask != 0
+#ifdef __GNUC__
+	return __builtin_ctz(mask);
+#else
+	int i = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		++i;
+	}
+	return i;
+#endif
+}
+
 enum Language {
 	LANG_FR,
 	LANG_EN,
@@ -90,6 +103,7 @@ struct Options {
 	bool use_tiledata;
 	bool use_text_cutscenes;
 	bool use_seq_cutscenes;
+	bool enable_rewind;
 };
 
 struct Color {
@@ -140,12 +154,8 @@ struct InitPGE {
 	uint16_t text_num;
 };
 
+// the per-frame fields obj_type, pos_x, pos_y, anim_seq, room_location and flags are stored in LivePGEHot
 struct LivePGE {
-	uint16_t obj_type;
-	int16_t pos_x;
-	int16_t pos_y;
-	uint8_t anim_seq;
-	uint8_t room_location;
 	int16_t life;
 	int16_t counter_value;
 	uint8_t collision_slot;
@@ -153,13 +163,21 @@ struct LivePGE {
 	uint8_t current_inventory_PGE;
 	uint8_t unkF; // unk_inventory_PGE
 	uint16_t anim_number;
-	uint8_t flags;
 	uint8_t index;
 	uint16_t first_obj_number;
 	LivePGE *next_PGE_in_room;
 	InitPGE *init_PGE;
 };
 
+struct LivePGEHot { // index = pge number
+	uint16_t obj_type[256];
+	int16_t pos_x[256];
+	int16_t pos_y[256];
+	uint8_t anim_seq[256];
+	uint8_t room_location[256];
+	uint8_t flags[256];
+};
+
 struct GroupPGE {
 	GroupPGE *next_entry;
 	uint16_t index;
@@ -181,10 +199,42 @@ struct Object {
 	int16_t opcode_arg3;
 };
 
+struct ObjectOpcode {
+	uint8_t num;
+	int16_t a; // arg2
+	int16_t b; // arg4
+};
+
+enum {
+	kObjectCodeAbort = 1 << 0, // an unresolved conditional opcode, the object always fails
+	kObjectCodeGroupSlice = 1 << 1, // a conditional opcode tests a group in the 1..4 range
+	kObjectCodeChainGroupSlice = 1 << 2 // set if any object left in the chain has kObjectCodeGroupSlice
+};
+
+struct ObjectCode {
+	uint16_t chain_end; // index past the last consecutive object with the same type
+	uint8_t num_ops;
+	uint8_t num_conds; // number of leading opcodes whose result is tested
+	uint8_t flags;
+	ObjectOpcode ops[3];
+};
+
 struct ObjectNode {
 	uint16_t last_obj_number;
 	Object *objects;
 	uint16_t num_objects;
+	ObjectCode *code;
+};
+
+struct StartupEvent {
+	const char *name;
+	uint64_t time;
+};
+
+struct OpcodeStats {
+	uint32_t calls;
+	uint32_t success;
+	uint64_t time; // ns
 };
 
 struct ObjectOpcodeArgs {
@@ -238,7 +288,6 @@ struct SoundFx {
 	uint8_t *data;
 };
 
-extern Options g_options;
 extern const char *g_caption;
 
 #endif // INTERN_H__
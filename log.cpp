@@ -0,0 +1,564 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifdef __ANDROID__
+#define LOG_TAG "FbJni"
+#include <android/log.h>
+#endif
+#include <SDL.h>
+#include "log.h"
+
+static const int kRecordsCount = 4096; // must be a power of 2
+static const int kRecordDataSize = 240;
+static const int kMaxStringLen = 128;
+static const int kWakeUpDelay = 10; // ms
+
+enum {
+	kLenNone,
+	kLenChar,
+	kLenShort,
+	kLenLong,
+	kLenLongLong,
+	kLenSize,
+	kLenLongDouble
+};
+
+struct FormatSpec {
+	const char *start; // after '%'
+	const char *len; // length modifier
+	const char *end; // after the conversion character
+	int lenType;
+	int stars;
+	char conv;
+};
+
+static const char *parseFormatSpec(const char *p, FormatSpec *spec) {
+	spec->start = p;
+	spec->stars = 0;
+	while (*p && strchr("-+ #0", *p)) {
+		++p;
+	}
+	for (int i = 0; i < 2; ++i) { // width and precision
+		if (i == 1) {
+			if (*p != '.') {
+				break;
+			}
+			++p;
+		}
+		if (*p == '*') {
+			++spec->stars;
+			++p;
+		} else {
+			while (*p >= '0' && *p <= '9') {
+				++p;
+			}
+		}
+	}
+	spec->len = p;
+	spec->lenType = kLenNone;
+	switch (*p) {
+	case 'h':
+		++p;
+		if (*p == 'h') {
+			++p;
+			spec->lenType = kLenChar;
+		} else {
+			spec->lenType = kLenShort;
+		}
+		break;
+	case 'l':
+		++p;
+		if (*p == 'l') {
+			++p;
+			spec->lenType = kLenLongLong;
+		} else {
+			spec->lenType = kLenLong;
+		}
+		break;
+	case 'j':
+		++p;
+		spec->lenType = kLenLongLong;
+		break;
+	case 'z':
+	case 't':
+		++p;
+		spec->lenType = kLenSize;
+		break;
+	case 'L':
+		++p;
+		spec->lenType = kLenLongDouble;
+		break;
+	}
+	spec->conv = *p;
+	if (*p) {
+		++p;
+	}
+	spec->end = p;
+	return p;
+}
+
+struct LogRecord {
+	SDL_atomic_t seq;
+	uint8_t level;
+	uint16_t size;
+	const char *msg;
+	uint8_t data[kRecordDataSize]; // arguments, 8 bytes per value and the strings contents
+};
+
+struct LogRecordWriter {
+	LogRecord *_rec;
+
+	bool put(const void *p, int size) {
+		if (_rec->size + size > kRecordDataSize) {
+			return false;
+		}
+		memcpy(_rec->data + _rec->size, p, size);
+		_rec->size += size;
+		return true;
+	}
+	bool putInt(int64_t i) {
+		return put(&i, sizeof(i));
+	}
+	bool putDouble(double d) {
+		return put(&d, sizeof(d));
+	}
+	bool putString(const char *s) {
+		if (!s) {
+			s = "(null)";
+		}
+		const uint8_t len = MIN(strlen(s), (size_t)kMaxStringLen);
+		return put(&len, 1) && put(s, len);
+	}
+};
+
+struct LogRecordReader {
+	const LogRecord *_rec;
+	int _pos;
+
+	bool get(void *p, int size) {
+		if (_pos + size > _rec->size) {
+			return false;
+		}
+		memcpy(p, _rec->data + _pos, size);
+		_pos += size;
+		return true;
+	}
+};
+
+static bool encodeArgs(LogRecordWriter *w, const char *msg, va_list va) {
+	const char *p = msg;
+	while ((p = strchr(p, '%')) != 0) {
+		FormatSpec spec;
+		p = parseFormatSpec(p + 1, &spec);
+		for (int i = 0; i < spec.stars; ++i) {
+			if (!w->putInt(va_arg(va, int))) {
+				return false;
+			}
+		}
+		bool ret = true;
+		switch (spec.conv) {
+		case 'd':
+		case 'i':
+			switch (spec.lenType) {
+			case kLenChar:
+				ret = w->putInt((signed char)va_arg(va, int));
+				break;
+			case kLenShort:
+				ret = w->putInt((short)va_arg(va, int));
+				break;
+			case kLenLong:
+				ret = w->putInt(va_arg(va, long));
+				break;
+			case kLenLongLong:
+				ret = w->putInt(va_arg(va, long long));
+				break;
+			case kLenSize:
+				ret = w->putInt(va_arg(va, ptrdiff_t));
+				break;
+			default:
+				ret = w->putInt(va_arg(va, int));
+				break;
+			}
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			switch (spec.lenType) {
+			case kLenChar:
+				ret = w->putInt((unsigned char)va_arg(va, unsigned int));
+				break;
+			case kLenShort:
+				ret = w->putInt((unsigned short)va_arg(va, unsigned int));
+				break;
+			case kLenLong:
+				ret = w->putInt(va_arg(va, unsigned long));
+				break;
+			case kLenLongLong:
+				ret = w->putInt(va_arg(va, unsigned long long));
+				break;
+			case kLenSize:
+				ret = w->putInt(va_arg(va, size_t));
+				break;
+			default:
+				ret = w->putInt(va_arg(va, unsigned int));
+				break;
+			}
+			break;
+		case 'c':
+			ret = w->putInt(va_arg(va, int));
+			break;
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			if (spec.lenType == kLenLongDouble) {
+				ret = w->putDouble(va_arg(va, long double));
+			} else {
+				ret = w->putDouble(va_arg(va, double));
+			}
+			break;
+		case 's':
+			ret = w->putString(va_arg(va, const char *));
+			break;
+		case 'p':
+			ret = w->putInt((uintptr_t)va_arg(va, void *));
+			break;
+		}
+		if (!ret) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template<typename T>
+static int formatValue(char *dst, int size, const char *fmt, const int *stars, int starsCount, T value) {
+	switch (starsCount) {
+	case 1:
+		return snprintf(dst, size, fmt, stars[0], value);
+	case 2:
+		return snprintf(dst, size, fmt, stars[0], stars[1], value);
+	default:
+		return snprintf(dst, size, fmt, value);
+	}
+}
+
+static void formatRecord(const LogRecord *rec, char *dst, int size) {
+	LogRecordReader r;
+	r._rec = rec;
+	r._pos = 0;
+	int len = 0;
+	const char *p = rec->msg;
+	while (*p && len < size - 1) {
+		if (*p != '%') {
+			dst[len++] = *p++;
+			continue;
+		}
+		FormatSpec spec;
+		p = parseFormatSpec(p + 1, &spec);
+		if (spec.conv == '%') {
+			dst[len++] = '%';
+			continue;
+		}
+		int stars[2];
+		bool ret = true;
+		for (int i = 0; i < spec.stars; ++i) {
+			int64_t value = 0;
+			ret = ret && r.get(&value, sizeof(value));
+			stars[i] = (int)value;
+		}
+		// rebuild the conversion, the integer values are stored as 64 bits
+		char fmt[32];
+		int fmtLen = spec.len - spec.start + 1;
+		if (fmtLen > (int)sizeof(fmt) - 4) {
+			break;
+		}
+		fmt[0] = '%';
+		memcpy(fmt + 1, spec.start, fmtLen - 1);
+		int count = 0;
+		switch (spec.conv) {
+		case 'd':
+		case 'i': {
+				int64_t value;
+				if (ret && r.get(&value, sizeof(value))) {
+					snprintf(fmt + fmtLen, sizeof(fmt) - fmtLen, "ll%c", spec.conv);
+					count = formatValue(dst + len, size - len, fmt, stars, spec.stars, (long long)value);
+				} else {
+					ret = false;
+				}
+			}
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o': {
+				int64_t value;
+				if (ret && r.get(&value, sizeof(value))) {
+					snprintf(fmt + fmtLen, sizeof(fmt) - fmtLen, "ll%c", spec.conv);
+					count = formatValue(dst + len, size - len, fmt, stars, spec.stars, (unsigned long long)value);
+				} else {
+					ret = false;
+				}
+			}
+			break;
+		case 'c':
+		case 'p': {
+				int64_t value;
+				if (ret && r.get(&value, sizeof(value))) {
+					snprintf(fmt + fmtLen, sizeof(fmt) - fmtLen, "%c", spec.conv);
+					if (spec.conv == 'c') {
+						count = formatValue(dst + len, size - len, fmt, stars, spec.stars, (int)value);
+					} else {
+						count = formatValue(dst + len, size - len, fmt, stars, spec.stars, (void *)(uintptr_t)value);
+					}
+				} else {
+					ret = false;
+				}
+			}
+			break;
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A': {
+				double value;
+				if (ret && r.get(&value, sizeof(value))) {
+					snprintf(fmt + fmtLen, sizeof(fmt) - fmtLen, "%c", spec.conv);
+					count = formatValue(dst + len, size - len, fmt, stars, spec.stars, value);
+				} else {
+					ret = false;
+				}
+			}
+			break;
+		case 's': {
+				uint8_t strLen;
+				char str[kMaxStringLen + 1];
+				if (ret && r.get(&strLen, 1) && r.get(str, strLen)) {
+					str[strLen] = 0;
+					snprintf(fmt + fmtLen, sizeof(fmt) - fmtLen, "s");
+					count = formatValue(dst + len, size - len, fmt, stars, spec.stars, (const char *)str);
+				} else {
+					ret = false;
+				}
+			}
+			break;
+		default:
+			// not a valid conversion, copied as is
+			count = snprintf(dst + len, size - len, "%%%.*s", (int)(spec.end - spec.start), spec.start);
+			break;
+		}
+		if (!ret) {
+			// the arguments did not fit in the record
+			count = snprintf(dst + len, size - len, "...");
+			len += MIN(count, size - 1 - len);
+			break;
+		}
+		len += MIN(count, size - 1 - len);
+	}
+	dst[len] = 0;
+}
+
+static void outputMessage(int level, const char *buf) {
+	if (level == kLogWarning) {
+		fprintf(stderr, "WARNING: %s!\n", buf);
+#ifdef __ANDROID__
+		__android_log_print(ANDROID_LOG_WARN, LOG_TAG, "%s", buf);
+#endif
+	} else {
+		fprintf(stdout, "%s\n", buf);
+#ifdef __ANDROID__
+		__android_log_print(ANDROID_LOG_INFO, LOG_TAG, "%s", buf);
+#endif
+	}
+}
+
+struct Logger {
+	LogRecord *_records;
+	SDL_atomic_t _writePos; // producers
+	uint32_t _readPos; // logger thread
+	SDL_atomic_t _writtenPos; // last record written, for flush()
+	SDL_atomic_t _dropped;
+	SDL_atomic_t _sleeping;
+	SDL_atomic_t _quit;
+	SDL_sem *_wakeUp;
+	SDL_Thread *_thread;
+
+	bool start();
+	void stop();
+	void flush();
+	void write(int level, const char *msg, va_list va);
+	bool processRecords();
+	static int loggerThread(void *param);
+};
+
+static Logger _logger;
+
+bool Logger::start() {
+	_records = (LogRecord *)calloc(kRecordsCount, sizeof(LogRecord));
+	if (!_records) {
+		return false;
+	}
+	for (int i = 0; i < kRecordsCount; ++i) {
+		SDL_AtomicSet(&_records[i].seq, i);
+	}
+	SDL_AtomicSet(&_writePos, 0);
+	_readPos = 0;
+	SDL_AtomicSet(&_writtenPos, 0);
+	SDL_AtomicSet(&_dropped, 0);
+	SDL_AtomicSet(&_sleeping, 0);
+	SDL_AtomicSet(&_quit, 0);
+	_wakeUp = SDL_CreateSemaphore(0);
+	if (_wakeUp) {
+		_thread = SDL_CreateThread(loggerThread, "Logger", this);
+		if (_thread) {
+			return true;
+		}
+		SDL_DestroySemaphore(_wakeUp);
+		_wakeUp = 0;
+	}
+	free(_records);
+	_records = 0;
+	return false;
+}
+
+void Logger::stop() {
+	if (_thread) {
+		SDL_AtomicSet(&_quit, 1);
+		SDL_SemPost(_wakeUp);
+		SDL_WaitThread(_thread, 0);
+		_thread = 0;
+		SDL_DestroySemaphore(_wakeUp);
+		_wakeUp = 0;
+		free(_records);
+		_records = 0;
+	}
+}
+
+void Logger::flush() {
+	if (_thread) {
+		const uint32_t pos = SDL_AtomicGet(&_writePos);
+		SDL_SemPost(_wakeUp);
+		while ((int)(SDL_AtomicGet(&_writtenPos) - pos) < 0) {
+			SDL_Delay(1);
+		}
+	}
+}
+
+static void writeMessage(int level, const char *msg, va_list va) {
+	char buf[1024];
+	vsnprintf(buf, sizeof(buf), msg, va);
+	outputMessage(level, buf);
+	fflush(level == kLogWarning ? stderr : stdout);
+}
+
+void Logger::write(int level, const char *msg, va_list va) {
+	if (!_thread) {
+		writeMessage(level, msg, va);
+		return;
+	}
+	// multiple producers bounded queue, each record has a sequence number telling if it is free
+	// for the write position or if it holds a message for the read position
+	uint32_t pos = SDL_AtomicGet(&_writePos);
+	LogRecord *rec;
+	while (1) {
+		rec = &_records[pos & (kRecordsCount - 1)];
+		const int dif = (int)((uint32_t)SDL_AtomicGet(&rec->seq) - pos);
+		if (dif == 0) {
+			if (SDL_AtomicCAS(&_writePos, pos, pos + 1)) {
+				break;
+			}
+		} else if (dif < 0) {
+			// the ring is full, the debug messages are dropped rather than blocking the caller
+			if (level == kLogWarning) {
+				writeMessage(level, msg, va);
+			} else {
+				SDL_AtomicAdd(&_dropped, 1);
+			}
+			return;
+		}
+		pos = SDL_AtomicGet(&_writePos);
+	}
+	rec->level = level;
+	rec->size = 0;
+	rec->msg = msg;
+	LogRecordWriter w;
+	w._rec = rec;
+	encodeArgs(&w, msg, va);
+	SDL_AtomicSet(&rec->seq, pos + 1);
+	if (SDL_AtomicGet(&_sleeping)) {
+		SDL_SemPost(_wakeUp);
+	}
+}
+
+bool Logger::processRecords() {
+	bool written = false;
+	while (1) {
+		LogRecord *rec = &_records[_readPos & (kRecordsCount - 1)];
+		if ((uint32_t)SDL_AtomicGet(&rec->seq) != _readPos + 1) {
+			break;
+		}
+		char buf[1024];
+		formatRecord(rec, buf, sizeof(buf));
+		const int level = rec->level;
+		SDL_AtomicSet(&rec->seq, _readPos + kRecordsCount);
+		++_readPos;
+		outputMessage(level, buf);
+		written = true;
+	}
+	const int dropped = SDL_AtomicSet(&_dropped, 0);
+	if (dropped != 0) {
+		fprintf(stderr, "WARNING: %d log messages dropped!\n", dropped);
+		written = true;
+	}
+	if (written) {
+		fflush(stdout);
+		fflush(stderr);
+	}
+	SDL_AtomicSet(&_writtenPos, _readPos);
+	return written;
+}
+
+int Logger::loggerThread(void *param) {
+	Logger *logger = (Logger *)param;
+	while (1) {
+		const bool quit = SDL_AtomicGet(&logger->_quit) != 0;
+		if (!logger->processRecords()) {
+			if (quit) {
+				break;
+			}
+			SDL_AtomicSet(&logger->_sleeping, 1);
+			SDL_SemWaitTimeout(logger->_wakeUp, kWakeUpDelay);
+			SDL_AtomicSet(&logger->_sleeping, 0);
+		}
+	}
+	return 0;
+}
+
+void startLogThread() {
+	if (!_logger._thread && !_logger.start()) {
+		fprintf(stderr, "WARNING: Unable to start the logger thread!\n");
+	}
+}
+
+void stopLogThread() {
+	_logger.stop();
+}
+
+void flushLog() {
+	_logger.flush();
+}
+
+void writeLog(int level, const char *msg, va_list va) {
+	_logger.write(level, msg, va);
+}
@@ -0,0 +1,27 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef LOG_H__
+#define LOG_H__
+
+#include <stdarg.h>
+#include "intern.h"
+
+// the messages are stored with their arguments in binary form in a lock-free ring and formatted
+// by a background thread. They are written by the calling thread while the thread is not running.
+// The format strings must be literals, they are only read when the message is written.
+
+enum {
+	kLogDebug,
+	kLogWarning
+};
+
+extern void startLogThread();
+extern void stopLogThread();
+extern void flushLog();
+extern void writeLog(int level, const char *msg, va_list va);
+
+#endif // LOG_H__
@@ -5,12 +5,13 @@
  */
 
 #include <SDL.h>
-#include <ctype.h>
 #include <getopt.h>
 #include <sys/stat.h>
-#include "file.h"
+#include "config.h"
+#include "dynlib.h"
 #include "fs.h"
 #include "game.h"
+#include "log.h"
 #include "scaler.h"
 #include "systemstub.h"
 #include "util.h"
@@ -24,109 +25,20 @@ static const char *USAGE =
 	"  --fullscreen      Fullscreen display\n"
 	"  --scaler=NAME@X   Graphics scaler (default 'scale@3')\n"
 	"  --language=LANG   Language (fr,en,de,sp,it)\n"
+	"  --playdemo=NUM    Play demo inputs (0-2)\n"
+	"  --benchmark       Headless and uncapped demo playback, report PGE throughput\n"
+	"  --profile         Print the startup timeline, the frames pacing jitter and\n"
+	"                    the PGE opcodes timings by level and room on exit\n"
+	"  --hash-trace=FILE Write the game state hash of each frame to FILE\n"
+	"  --hash-check=FILE Compare the game state hashes with a trace, report the first diverging frame\n"
+	"  --record=FILE     Record the keyboard inputs to FILE\n"
+	"  --replay=FILE     Play inputs recorded with --record\n"
+	"  --capture=NAME    Record the video and audio to NAME.y4m and NAME.wav\n"
+	"  --capture-delta   Record the video as indexed frames deltas to NAME.fbv\n"
+	"  --audio-stats     Log the audio callbacks timings every 10 seconds\n"
+	"  --present-thread  Run the game on a separate thread, the frames are presented by the main one\n"
 ;
 
-static int detectVersion(FileSystem *fs) {
-	static const struct {
-		const char *filename;
-		int type;
-		const char *name;
-	} table[] = {
-		{ "DEMO_UK.ABA", kResourceTypeDOS, "DOS (Demo)" },
-		{ "INTRO.SEQ", kResourceTypeDOS, "DOS CD" },
-		{ "LEVEL1.MAP", kResourceTypeDOS, "DOS" },
-		{ "LEVEL1.LEV", kResourceTypeAmiga, "Amiga" },
-		{ "DEMO.LEV", kResourceTypeAmiga, "Amiga (Demo)" },
-		{ 0, -1, 0 }
-	};
-	for (int i = 0; table[i].filename; ++i) {
-		File f;
-		if (f.open(table[i].filename, "rb", fs)) {
-			debug(DBG_INFO, "Detected %s version", table[i].name);
-			return table[i].type;
-		}
-	}
-	return -1;
-}
-
-static Language detectLanguage(FileSystem *fs) {
-	static const struct {
-		const char *filename;
-		Language language;
-	} table[] = {
-		// PC
-		{ "ENGCINE.TXT", LANG_EN },
-		{ "FR_CINE.TXT", LANG_FR },
-		{ "GERCINE.TXT", LANG_DE },
-		{ "SPACINE.TXT", LANG_SP },
-		{ "ITACINE.TXT", LANG_IT },
-		// Amiga
-		{ "FRCINE.TXT", LANG_FR },
-		{ 0, LANG_EN }
-	};
-	for (int i = 0; table[i].filename; ++i) {
-		File f;
-		if (f.open(table[i].filename, "rb", fs)) {
-			return table[i].language;
-		}
-	}
-	return LANG_EN;
-}
-
-Options g_options;
-const char *g_caption = "REminiscence";
-
-static void initOptions() {
-	// defaults
-	g_options.bypass_protection = true;
-	g_options.play_disabled_cutscenes = false;
-	g_options.enable_password_menu = false;
-	g_options.fade_out_palette = true;
-	g_options.use_text_cutscenes = false;
-	g_options.use_seq_cutscenes = true;
-	// read configuration file
-	struct {
-		const char *name;
-		bool *value;
-	} opts[] = {
-		{ "bypass_protection", &g_options.bypass_protection },
-		{ "play_disabled_cutscenes", &g_options.play_disabled_cutscenes },
-		{ "enable_password_menu", &g_options.enable_password_menu },
-		{ "fade_out_palette", &g_options.fade_out_palette },
-		{ "use_tiledata", &g_options.use_tiledata },
-		{ "use_text_cutscenes", &g_options.use_text_cutscenes },
-		{ "use_seq_cutscenes", &g_options.use_seq_cutscenes },
-		{ 0, 0 }
-	};
-	static const char *filename = "rs.cfg";
-	FILE *fp = fopen(filename, "rb");
-	if (fp) {
-		char buf[256];
-		while (fgets(buf, sizeof(buf), fp)) {
-			if (buf[0] == '#') {
-				continue;
-			}
-			const char *p = strchr(buf, '=');
-			if (p) {
-				++p;
-				while (*p && isspace(*p)) {
-					++p;
-				}
-				if (*p) {
-					const bool value = (*p == 't' || *p == 'T' || *p == '1');
-					for (int i = 0; opts[i].name; ++i) {
-						if (strncmp(buf, opts[i].name, strlen(opts[i].name)) == 0) {
-							*opts[i].value = value;
-							break;
-						}
-					}
-				}
-			}
-		}
-		fclose(fp);
-	}
-}
-
 static void parseScaler(char *name, ScalerParameters *scalerParameters) {
 	struct {
 		const char *name;
@@ -152,7 +64,7 @@ static void parseScaler(char *name, ScalerParameters *scalerParameters) {
 	if (!found) {
 		char libname[32];
 		snprintf(libname, sizeof(libname), "scaler_%s", name);
-		const Scaler *scaler = findScaler(libname);
+		const Scaler *scaler = findScaler(libname, &scalerParameters->dynLib);
 		if (scaler) {
 			scalerParameters->type = kScalerTypeExternal;
 			scalerParameters->scaler = scaler;
@@ -165,7 +77,12 @@ static void parseScaler(char *name, ScalerParameters *scalerParameters) {
 	}
 }
 
+static void runGame(void *param) {
+	((Game *)param)->run();
+}
+
 int main(int argc, char *argv[]) {
+	const uint64_t startupTime = getTimeNs();
 	const char *dataPath = "DATA";
 	const char *savePath = ".";
 	int levelNum = 0;
@@ -173,6 +90,16 @@ int main(int argc, char *argv[]) {
 	ScalerParameters scalerParameters = ScalerParameters::defaults();
 	int forcedLanguage = -1;
 	int demoNum = -1;
+	bool benchmark = false;
+	bool profile = false;
+	const char *hashTrace = 0;
+	const char *hashCheck = 0;
+	const char *recordPath = 0;
+	const char *replayPath = 0;
+	const char *capturePath = 0;
+	bool captureDelta = false;
+	bool audioStats = false;
+	bool presentThread = false;
 	if (argc == 2) {
 		// data path as the only command line argument
 		struct stat st;
@@ -189,6 +116,16 @@ int main(int argc, char *argv[]) {
 			{ "scaler",     required_argument, 0, 5 },
 			{ "language",   required_argument, 0, 6 },
 			{ "playdemo",   required_argument, 0, 7 },
+			{ "benchmark",  no_argument,       0, 8 },
+			{ "profile",    no_argument,       0, 9 },
+			{ "hash-trace", required_argument, 0, 10 },
+			{ "hash-check", required_argument, 0, 11 },
+			{ "record",     required_argument, 0, 12 },
+			{ "replay",     required_argument, 0, 13 },
+			{ "capture",    required_argument, 0, 14 },
+			{ "capture-delta", no_argument,    0, 15 },
+			{ "audio-stats", no_argument,      0, 16 },
+			{ "present-thread", no_argument,   0, 17 },
 			{ 0, 0, 0, 0 }
 		};
 		int index;
@@ -235,13 +172,48 @@ int main(int argc, char *argv[]) {
 		case 7:
 			demoNum = atoi(optarg);
 			break;
+		case 8:
+			benchmark = true;
+			break;
+		case 9:
+			profile = true;
+			break;
+		case 10:
+			hashTrace = strdup(optarg);
+			break;
+		case 11:
+			hashCheck = strdup(optarg);
+			break;
+		case 12:
+			recordPath = strdup(optarg);
+			break;
+		case 13:
+			replayPath = strdup(optarg);
+			break;
+		case 14:
+			capturePath = strdup(optarg);
+			break;
+		case 15:
+			captureDelta = true;
+			break;
+		case 16:
+			audioStats = true;
+			break;
+		case 17:
+			presentThread = true;
+			break;
 		default:
 			printf(USAGE, argv[0]);
 			return 0;
 		}
 	}
-	initOptions();
-	g_debugMask = DBG_INFO; // DBG_CUT | DBG_VIDEO | DBG_RES | DBG_MENU | DBG_PGE | DBG_GAME | DBG_UNPACK | DBG_COL | DBG_MOD | DBG_SFX | DBG_FILE;
+	Options options;
+	initOptions(&options);
+	g_debugMask = DBG_INFO; // DBG_CUT | DBG_VIDEO | DBG_RES | DBG_MENU | DBG_PGE | DBG_GAME | DBG_UNPACK | DBG_COL | DBG_MOD | DBG_SFX | DBG_FILE | DBG_AUDIO;
+	if (audioStats) {
+		g_debugMask |= DBG_AUDIO;
+	}
+	startLogThread();
 	FileSystem fs(dataPath);
 	const int version = detectVersion(&fs);
 	if (version == -1) {
@@ -249,12 +221,34 @@ int main(int argc, char *argv[]) {
 		return -1;
 	}
 	const Language language = (forcedLanguage == -1) ? detectLanguage(&fs) : (Language)forcedLanguage;
-	SystemStub *stub = SystemStub_SDL_create();
-	Game *g = new Game(stub, &fs, savePath, levelNum, demoNum, (ResourceType)version, language);
+	SystemStub *stub = 0;
+	if (benchmark) {
+		if (demoNum == -1 && !replayPath) {
+			demoNum = 0;
+		}
+		options.bypass_protection = true;
+		stub = SystemStub_Null_create();
+	} else {
+		stub = SystemStub_SDL_create(presentThread);
+	}
+	Game *g = new Game(stub, &fs, savePath, levelNum, demoNum, (ResourceType)version, language, options);
+	g->_startupTime = startupTime;
+	g->markStartupEvent("data files detection");
+	g->_benchmark = benchmark;
+	g->_profile = profile;
+	g->_hashTracePath = hashTrace;
+	g->_hashComparePath = hashCheck;
+	g->_recordPath = recordPath;
+	g->_replayPath = replayPath;
+	g->_capturePath = capturePath;
+	g->_captureDelta = captureDelta;
 	stub->init(g_caption, Video::GAMESCREEN_W, Video::GAMESCREEN_H, fullscreen, &scalerParameters);
-	g->run();
+	g->markStartupEvent("system init");
+	stub->runLoop(runGame, g);
 	delete g;
 	stub->destroy();
 	delete stub;
+	delete scalerParameters.dynLib;
+	stopLogThread();
 	return 0;
 }
@@ -11,8 +11,8 @@
 #include "util.h"
 #include "video.h"
 
-Menu::Menu(Resource *res, SystemStub *stub, Video *vid)
-	: _res(res), _stub(stub), _vid(vid) {
+Menu::Menu(Resource *res, SystemStub *stub, Video *vid, const Options *options)
+	: _res(res), _stub(stub), _vid(vid), _options(options) {
 	_skill = 1;
 	_level = 0;
 }
@@ -96,7 +96,7 @@ void Menu::handleInfoScreen() {
 	_vid->fullRefresh();
 	_vid->updateScreen();
 	do {
-		_stub->sleep(EVENTS_DELAY);
+		_stub->_scheduler.waitMs(EVENTS_DELAY);
 		_stub->processEvents();
 		if (_stub->_pi.escape) {
 			_stub->_pi.escape = false;
@@ -127,7 +127,7 @@ void Menu::handleSkillScreen() {
 		drawString(_res->getMenuString(LocaleData::LI_15_EXPERT), 19, 14, colors[skill_level][2]);
 
 		_vid->updateScreen();
-		_stub->sleep(EVENTS_DELAY);
+		_stub->_scheduler.waitMs(EVENTS_DELAY);
 		_stub->processEvents();
 
 		if (_stub->_pi.dirMask & PlayerInput::DIR_UP) {
@@ -180,7 +180,7 @@ bool Menu::handlePasswordScreen() {
 
 		_vid->markBlockAsDirty(15 * 8, 21 * 8, (len + 1) * 8, 8);
 		_vid->updateScreen();
-		_stub->sleep(EVENTS_DELAY);
+		_stub->_scheduler.waitMs(EVENTS_DELAY);
 		_stub->processEvents();
 		char c = _stub->_pi.lastChar;
 		if (c != 0) {
@@ -251,7 +251,7 @@ bool Menu::handleLevelScreen() {
 		_vid->markBlockAsDirty(4 * 8, 23 * 8, 192, 8);
 
 		_vid->updateScreen();
-		_stub->sleep(EVENTS_DELAY);
+		_stub->_scheduler.waitMs(EVENTS_DELAY);
 		_stub->processEvents();
 
 		if (_stub->_pi.dirMask & PlayerInput::DIR_UP) {
@@ -316,7 +316,7 @@ void Menu::handleTitleScreen() {
 	menuItems[menuItemsCount].str = LocaleData::LI_07_START;
 	menuItems[menuItemsCount].opt = MENU_OPTION_ITEM_START;
 	++menuItemsCount;
-	if (g_options.enable_password_menu) {
+	if (_options->enable_password_menu) {
 		menuItems[menuItemsCount].str = LocaleData::LI_08_SKILL;
 		menuItems[menuItemsCount].opt = MENU_OPTION_ITEM_SKILL;
 		++menuItemsCount;
@@ -360,7 +360,7 @@ void Menu::handleTitleScreen() {
 		}
 
 		_vid->updateScreen();
-		_stub->sleep(EVENTS_DELAY);
+		_stub->_scheduler.waitMs(EVENTS_DELAY);
 		_stub->processEvents();
 
 		if (_stub->_pi.dirMask & PlayerInput::DIR_UP) {
@@ -46,6 +46,7 @@ struct Menu {
 	Resource *_res;
 	SystemStub *_stub;
 	Video *_vid;
+	const Options *_options;
 
 	int _currentScreen;
 	int _nextScreen;
@@ -60,7 +61,7 @@ struct Menu {
 	uint8_t _charVar4;
 	uint8_t _charVar5;
 
-	Menu(Resource *res, SystemStub *stub, Video *vid);
+	Menu(Resource *res, SystemStub *stub, Video *vid, const Options *options);
 
 	void drawString(const char *str, int16_t y, int16_t x, uint8_t color);
 	void drawString2(const char *str, int16_t y, int16_t x);
@@ -4,6 +4,7 @@
  * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
  */
 
+#include "capture.h"
 #include "mixer.h"
 #include "systemstub.h"
 #include "util.h"
@@ -11,6 +12,7 @@
 Mixer::Mixer(FileSystem *fs, SystemStub *stub)
 	: _stub(stub), _musicType(MT_NONE), _mod(this, fs), _ogg(this, fs), _sfx(this) {
 	_musicTrack = -1;
+	_capture = 0;
 }
 
 void Mixer::init() {
@@ -32,6 +34,11 @@ void Mixer::setPremixHook(PremixHook premixHook, void *userData) {
 	_premixHookData = userData;
 }
 
+void Mixer::setCapture(VideoCapture *capture) {
+	LockAudioStack las(_stub);
+	_capture = capture;
+}
+
 void Mixer::play(const MixerChunk *mc, uint16_t freq, uint8_t volume) {
 	debug(DBG_SND, "Mixer::play(%d, %d)", freq, volume);
 	LockAudioStack las(_stub);
@@ -160,6 +167,9 @@ void Mixer::mix(int16_t *out, int len) {
 			}
 		}
 	}
+	if (_capture) {
+		_capture->pushAudio(out, len);
+	}
 }
 
 void Mixer::mixCallback(void *param, int16_t *buf, int len) {
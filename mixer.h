@@ -40,6 +40,7 @@ struct MixerChannel {
 
 struct FileSystem;
 struct SystemStub;
+struct VideoCapture;
 
 struct Mixer {
 	typedef bool (*PremixHook)(void *userData, int16_t *buf, int len);
@@ -68,11 +69,13 @@ struct Mixer {
 	OggPlayer _ogg;
 	SfxPlayer _sfx;
 	int _musicTrack;
+	VideoCapture *_capture;
 
 	Mixer(FileSystem *fs, SystemStub *stub);
 	void init();
 	void free();
 	void setPremixHook(PremixHook premixHook, void *userData);
+	void setCapture(VideoCapture *capture);
 	void play(const MixerChunk *mc, uint16_t freq, uint8_t volume);
 	bool isPlaying(const MixerChunk *mc) const;
 	uint32_t getSampleRate() const;
@@ -0,0 +1,119 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include <stdarg.h>
+#include "perf_hud.h"
+#include "systemstub.h"
+
+// 3x5 glyphs, characters 32 (' ') to 90 ('Z'), 3 bits per row
+static const uint16_t _font3x5[] = {
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x52A5, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01C0, 0x0002, 0x12A4,
+	0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249,
+	0x7BEF, 0x7BCF, 0x0410, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,
+	0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,
+	0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,
+	0x5AAD, 0x5A92, 0x72A7
+};
+
+static const uint32_t kBackgroundColor = 0xC0000000;
+static const uint32_t kTextColor = 0xFFFFFFFF;
+static const uint32_t kLabelColor = 0xFFA0A0A0;
+static const uint32_t kGraphColor = 0xFF40E040;
+static const uint32_t kGraphSlowColor = 0xFFE04040;
+static const uint32_t kGraphLineColor = 0xFF606060;
+
+static const int kFrameBudget = 1000000 / 30; // us
+
+PerfHud::PerfHud()
+	: _frameTimesPos(0), _lastFrameTime(0) {
+	memset(_buffer, 0, sizeof(_buffer));
+	memset(_frameTimes, 0, sizeof(_frameTimes));
+}
+
+void PerfHud::addFrame(uint64_t timestamp) {
+	if (_lastFrameTime != 0) {
+		_frameTimes[_frameTimesPos] = (timestamp - _lastFrameTime) / 1000;
+		_frameTimesPos = (_frameTimesPos + 1) % kGraphSamples;
+	}
+	_lastFrameTime = timestamp;
+}
+
+void PerfHud::fillRect(int x, int y, int w, int h, uint32_t color) {
+	for (int j = 0; j < h; ++j) {
+		uint32_t *p = _buffer + (y + j) * kW + x;
+		for (int i = 0; i < w; ++i) {
+			p[i] = color;
+		}
+	}
+}
+
+void PerfHud::drawText(int x, int y, uint32_t color, const char *fmt, ...) {
+	char buf[64];
+	va_list va;
+	va_start(va, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, va);
+	va_end(va);
+	for (int i = 0; buf[i] && x + 3 <= kW; ++i, x += kCharW) {
+		int chr = buf[i];
+		if (chr >= 'a' && chr <= 'z') {
+			chr -= 'a' - 'A';
+		}
+		if (chr < 32 || chr > 'Z') {
+			continue;
+		}
+		const uint16_t glyph = _font3x5[chr - 32];
+		for (int j = 0; j < 5; ++j) {
+			const int bits = (glyph >> ((4 - j) * 3)) & 7;
+			uint32_t *p = _buffer + (y + j) * kW + x;
+			for (int k = 0; k < 3; ++k) {
+				if (bits & (4 >> k)) {
+					p[k] = color;
+				}
+			}
+		}
+	}
+}
+
+void PerfHud::draw(const PerfStats *stats) {
+	fillRect(0, 0, kW, kH, kBackgroundColor);
+	int y = 2;
+	const int lastPos = (_frameTimesPos + kGraphSamples - 1) % kGraphSamples;
+	uint32_t maxTime = 0;
+	for (int i = 0; i < kGraphSamples; ++i) {
+		maxTime = MAX(maxTime, _frameTimes[i]);
+	}
+	drawText(2, y, kTextColor, "FRAME %.1f MS MAX %.1f", _frameTimes[lastPos] / 1000., maxTime / 1000.);
+	y += kCharH;
+	// the graph is scaled to two frames budget, the line is the budget of a frame
+	const int graphY = y + kGraphH;
+	fillRect(2, graphY - kGraphH / 2, kGraphSamples, 1, kGraphLineColor);
+	for (int i = 0; i < kGraphSamples; ++i) {
+		const uint32_t t = _frameTimes[(_frameTimesPos + i) % kGraphSamples];
+		const int h = MIN((int)(t * (kGraphH / 2) / kFrameBudget), (int)kGraphH);
+		fillRect(2 + i, graphY - h, 1, h, (t > kFrameBudget + kFrameBudget / 10) ? kGraphSlowColor : kGraphColor);
+	}
+	y = graphY + 2;
+	static const char *names[] = { "IN", "LOGIC", "DRAW", "PRESENT", "WAIT", "MISC" };
+	for (int i = 0; i < PerfStats::PHASES_COUNT; ++i) {
+		const int x = 2 + (i & 1) * (kW / 2);
+		drawText(x, y, kLabelColor, "%s", names[i]);
+		drawText(x + 8 * kCharW, y, kTextColor, "%.2f", stats->phaseTime[i] / 1000.);
+		if (i & 1) {
+			y += kCharH;
+		}
+	}
+	drawText(2, y, kLabelColor, "RECTS");
+	drawText(2 + 6 * kCharW, y, kTextColor, "%u AREA %u", stats->dirtyRects, stats->dirtyArea);
+	y += kCharH;
+	drawText(2, y, kLabelColor, "AUDIO");
+	drawText(2 + 6 * kCharW, y, kTextColor, "%u%% UNDERRUNS %u", stats->audioLoad, stats->audioUnderruns);
+	y += kCharH;
+	const uint32_t lookups = stats->bankHits + stats->bankMisses;
+	drawText(2, y, kLabelColor, "BANKS");
+	drawText(2 + 6 * kCharW, y, kTextColor, "%u%% HITS %u/%u", lookups ? stats->bankHits * 100 / lookups : 0, stats->bankHits, lookups);
+}
@@ -0,0 +1,40 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef PERF_HUD_H__
+#define PERF_HUD_H__
+
+#include "intern.h"
+
+struct PerfStats;
+
+// performance overlay, drawn to a 32 bits ARGB buffer blended over the scaled game screen
+
+struct PerfHud {
+	enum {
+		kW = 128,
+		kH = 80,
+		kGraphH = 24,
+		kGraphSamples = kW - 4,
+		kCharW = 4,
+		kCharH = 6
+	};
+
+	uint32_t _buffer[kW * kH];
+	uint32_t _frameTimes[kGraphSamples]; // us
+	int _frameTimesPos;
+	uint64_t _lastFrameTime;
+
+	PerfHud();
+
+	void addFrame(uint64_t timestamp);
+	void draw(const PerfStats *stats);
+
+	void fillRect(int x, int y, int w, int h, uint32_t color);
+	void drawText(int x, int y, uint32_t color, const char *fmt, ...);
+};
+
+#endif // PERF_HUD_H__
@@ -62,11 +62,11 @@ void Game::pge_loadForCurrentLevel(uint16_t idx) {
 	InitPGE *init_pge = &_res._pgeInit[idx];
 
 	live_pge->init_PGE = init_pge;
-	live_pge->obj_type = init_pge->type;
-	live_pge->pos_x = init_pge->pos_x;
-	live_pge->pos_y = init_pge->pos_y;
-	live_pge->anim_seq = 0;
-	live_pge->room_location = init_pge->init_room;
+	pge_objType(live_pge) = init_pge->type;
+	pge_posX(live_pge) = init_pge->pos_x;
+	pge_posY(live_pge) = init_pge->pos_y;
+	pge_animSeq(live_pge) = 0;
+	pge_roomLocation(live_pge) = init_pge->init_room;
 
 	live_pge->life = init_pge->life;
 	if (_skillLevel >= 2 && init_pge->object_type == 10) {
@@ -85,7 +85,7 @@ void Game::pge_loadForCurrentLevel(uint16_t idx) {
 	if (init_pge->skill <= _skillLevel) {
 		if (init_pge->room_location != 0 || ((init_pge->flags & 4) && (_currentRoom == init_pge->init_room))) {
 			flags |= 4;
-			_pge_liveTable2[idx] = live_pge;
+			pge_activate(live_pge);
 		}
 		if (init_pge->mirror_x != 0) {
 			flags |= 1;
@@ -97,12 +97,12 @@ void Game::pge_loadForCurrentLevel(uint16_t idx) {
 		if (init_pge->flags & 2) {
 			flags |= 0x80;
 		}
-		live_pge->flags = flags;
+		pge_flags(live_pge) = flags;
 		assert(init_pge->obj_node_number < _res._numObjectNodes);
 		ObjectNode *on = _res._objectNodesMap[init_pge->obj_node_number];
 		Object *obj = on->objects;
 		int i = 0;
-		while (obj->type != live_pge->obj_type) {
+		while (obj->type != pge_objType(live_pge)) {
 			++i;
 			++obj;
 		}
@@ -112,29 +112,57 @@ void Game::pge_loadForCurrentLevel(uint16_t idx) {
 	}
 }
 
+void Game::pge_resolveOpcodes() {
+	ObjectNode *prevNode = 0;
+	for (int i = 0; i < _res._numObjectNodes; ++i) {
+		ObjectNode *on = _res._objectNodesMap[i];
+		if (on == prevNode) {
+			continue;
+		}
+		prevNode = on;
+		for (int j = 0; j < on->num_objects; ++j) {
+			ObjectCode *code = &on->code[j];
+			for (int k = 0; k < code->num_ops; ++k) {
+				const uint8_t num = code->ops[k].num;
+				if (num < _pge_opcodeTableSize && _pge_opcodeTable[num]) {
+					continue;
+				}
+				warning("Game::pge_resolveOpcodes() missing call to pge_opcode 0x%X", num);
+				if (k < code->num_conds) {
+					code->num_conds = k;
+					code->flags |= kObjectCodeAbort;
+				}
+				code->num_ops = k;
+				break;
+			}
+		}
+	}
+}
+
 void Game::pge_process(LivePGE *pge) {
 	debug(DBG_PGE, "Game::pge_process() pge_num=%ld", pge - &_pgeLive[0]);
 	_pge_playAnimSound = true;
-	_pge_currentPiegeFacingDir = (pge->flags & 1) != 0;
-	_pge_currentPiegeRoom = pge->room_location;
+	_pge_currentPiegeFacingDir = (pge_flags(pge) & 1) != 0;
+	_pge_currentPiegeRoom = pge_roomLocation(pge);
 	GroupPGE *le = _pge_groupsTable[pge->index];
 	if (le) {
 		pge_setupNextAnimFrame(pge, le);
 	}
-	const uint8_t *anim_data = _res.getAniData(pge->obj_type);
-	if (_res._readUint16(anim_data) <= pge->anim_seq) {
+	const uint8_t *anim_data = _res.getAniData(pge_objType(pge));
+	if (_res._readUint16(anim_data) <= pge_animSeq(pge)) {
 		InitPGE *init_pge = pge->init_PGE;
 		assert(init_pge->obj_node_number < _res._numObjectNodes);
 		ObjectNode *on = _res._objectNodesMap[init_pge->obj_node_number];
-		Object *obj = &on->objects[pge->first_obj_number];
+		int i = pge->first_obj_number;
+		const int end = on->code[i].chain_end;
 		while (1) {
-			if (obj->type != pge->obj_type) {
+			if (i >= end || on->objects[i].type != pge_objType(pge)) {
 				pge_removeFromGroup(pge->index);
 				return;
 			}
-			uint16_t _ax = pge_execute(pge, init_pge, obj);
+			uint16_t _ax = pge_execute(pge, init_pge, &on->objects[i], &on->code[i]);
 			if (_ax != 0) {
-				anim_data = _res.getAniData(pge->obj_type);
+				anim_data = _res.getAniData(pge_objType(pge));
 				uint8_t snd = anim_data[2];
 				if (snd) {
 					pge_playAnimSound(pge, snd);
@@ -142,11 +170,11 @@ void Game::pge_process(LivePGE *pge) {
 				pge_setupOtherPieges(pge, init_pge);
 				break;
 			}
-			++obj;
+			++i;
 		}
 	}
 	pge_setupAnim(pge);
-	++pge->anim_seq;
+	++pge_animSeq(pge);
 	pge_removeFromGroup(pge->index);
 }
 
@@ -156,7 +184,8 @@ void Game::pge_setupNextAnimFrame(LivePGE *pge, GroupPGE *le) {
 	ObjectNode *on = _res._objectNodesMap[init_pge->obj_node_number];
 	Object *obj = &on->objects[pge->first_obj_number];
 	int i = pge->first_obj_number;
-	while (i < on->last_obj_number && pge->obj_type == obj->type) {
+	const int end = MIN(on->code[i].chain_end, on->last_obj_number);
+	while (i < end && pge_objType(pge) == obj->type) {
 		GroupPGE *next_le = le;
 		while (next_le) {
 			uint16_t groupId = next_le->group_id;
@@ -188,37 +217,37 @@ void Game::pge_setupNextAnimFrame(LivePGE *pge, GroupPGE *le) {
 	return;
 
 set_anim:
-	const uint8_t *anim_data = _res.getAniData(pge->obj_type);
+	const uint8_t *anim_data = _res.getAniData(pge_objType(pge));
 	uint8_t _dh = _res._readUint16(anim_data);
-	uint8_t _dl = pge->anim_seq;
+	uint8_t _dl = pge_animSeq(pge);
 	const uint8_t *anim_frame = anim_data + 6 + _dl * 4;
 	while (_dh > _dl) {
 		if (READ_LE_UINT16(anim_frame) != 0xFFFF) {
 			if (_pge_currentPiegeFacingDir) {
-				pge->pos_x -= (int8_t)anim_frame[2];
+				pge_posX(pge) -= (int8_t)anim_frame[2];
 			} else {
-				pge->pos_x += (int8_t)anim_frame[2];
+				pge_posX(pge) += (int8_t)anim_frame[2];
 			}
-			pge->pos_y += (int8_t)anim_frame[3];
+			pge_posY(pge) += (int8_t)anim_frame[3];
 		}
 		anim_frame += 4;
 		++_dl;
 	}
-	pge->anim_seq = _dh;
-	_col_currentPiegeGridPosY = (pge->pos_y / 36) & ~1;
-	_col_currentPiegeGridPosX = (pge->pos_x + 8) >> 4;
+	pge_animSeq(pge) = _dh;
+	_col_currentPiegeGridPosY = (pge_posY(pge) / 36) & ~1;
+	_col_currentPiegeGridPosX = (pge_posX(pge) + 8) >> 4;
 }
 
 void Game::pge_playAnimSound(LivePGE *pge, uint16_t arg2) {
-	if ((pge->flags & 4) && _pge_playAnimSound) {
+	if ((pge_flags(pge) & 4) && _pge_playAnimSound) {
 		uint8_t sfxId = (arg2 & 0xFF) - 1;
-		if (_currentRoom == pge->room_location) {
+		if (_currentRoom == pge_roomLocation(pge)) {
 			playSound(sfxId, 0);
 		} else {
-			if (_res._ctData[CT_DOWN_ROOM + _currentRoom] == pge->room_location ||
-				_res._ctData[CT_UP_ROOM + _currentRoom] == pge->room_location ||
-				_res._ctData[CT_RIGHT_ROOM + _currentRoom] == pge->room_location ||
-				_res._ctData[CT_LEFT_ROOM + _currentRoom] == pge->room_location) {
+			if (_res._ctData[CT_DOWN_ROOM + _currentRoom] == pge_roomLocation(pge) ||
+				_res._ctData[CT_UP_ROOM + _currentRoom] == pge_roomLocation(pge) ||
+				_res._ctData[CT_RIGHT_ROOM + _currentRoom] == pge_roomLocation(pge) ||
+				_res._ctData[CT_LEFT_ROOM + _currentRoom] == pge_roomLocation(pge)) {
 				playSound(sfxId, 1);
 			}
 		}
@@ -227,82 +256,58 @@ void Game::pge_playAnimSound(LivePGE *pge, uint16_t arg2) {
 
 void Game::pge_setupAnim(LivePGE *pge) {
 	debug(DBG_PGE, "Game::pge_setupAnim() pgeNum=%ld", pge - &_pgeLive[0]);
-	const uint8_t *anim_data = _res.getAniData(pge->obj_type);
-	if (_res._readUint16(anim_data) < pge->anim_seq) {
-		pge->anim_seq = 0;
+	const uint8_t *anim_data = _res.getAniData(pge_objType(pge));
+	if (_res._readUint16(anim_data) < pge_animSeq(pge)) {
+		pge_animSeq(pge) = 0;
 	}
-	const uint8_t *anim_frame = anim_data + 6 + pge->anim_seq * 4;
+	const uint8_t *anim_frame = anim_data + 6 + pge_animSeq(pge) * 4;
 	if (_res._readUint16(anim_frame) != 0xFFFF) {
 		uint16_t fl = _res._readUint16(anim_frame);
-		if (pge->flags & 1) {
+		if (pge_flags(pge) & 1) {
 			fl ^= 0x8000;
-			pge->pos_x -= (int8_t)anim_frame[2];
+			pge_posX(pge) -= (int8_t)anim_frame[2];
 		} else {
-			pge->pos_x += (int8_t)anim_frame[2];
+			pge_posX(pge) += (int8_t)anim_frame[2];
 		}
-		pge->pos_y += (int8_t)anim_frame[3];
-		pge->flags &= ~2;
+		pge_posY(pge) += (int8_t)anim_frame[3];
+		pge_flags(pge) &= ~2;
 		if (fl & 0x8000) {
-			pge->flags |= 2;
+			pge_flags(pge) |= 2;
 		}
-		pge->flags &= ~8;
+		pge_flags(pge) &= ~8;
 		if (_res._readUint16(anim_data + 4) & 0xFFFF) {
-			pge->flags |= 8;
+			pge_flags(pge) |= 8;
 		}
 		pge->anim_number = _res._readUint16(anim_frame) & 0x7FFF;
 	}
 }
 
-int Game::pge_execute(LivePGE *live_pge, InitPGE *init_pge, const Object *obj) {
+int Game::pge_execute(LivePGE *live_pge, InitPGE *init_pge, const Object *obj, const ObjectCode *code) {
 	debug(DBG_PGE, "Game::pge_execute() pge_num=%ld op1=0x%X op2=0x%X op3=0x%X", live_pge - &_pgeLive[0], obj->opcode1, obj->opcode2, obj->opcode3);
-	pge_OpcodeProc op;
+	// handlers are resolved at load time, see pge_resolveOpcodes()
 	ObjectOpcodeArgs args;
-	if (obj->opcode1) {
-		args.pge = live_pge;
-		args.a = obj->opcode_arg1;
-		args.b = 0;
-		debug(DBG_PGE, "pge_execute op1=0x%X", obj->opcode1);
-		op = _pge_opcodeTable[obj->opcode1];
-		if (!op) {
-			warning("Game::pge_execute() missing call to pge_opcode 0x%X", obj->opcode1);
+	args.pge = live_pge;
+	for (int i = 0; i < code->num_ops; ++i) {
+		const ObjectOpcode *op = &code->ops[i];
+		args.a = op->a;
+		args.b = op->b;
+		debug(DBG_PGE, "pge_execute op=0x%X", op->num);
+		const int ret = _profile ? pge_profileOpcode(op->num, &args) : (this->*_pge_opcodeTable[op->num])(&args);
+		if (i < code->num_conds && !(ret & 0xFF)) {
 			return 0;
 		}
-		if (!((this->*op)(&args) & 0xFF))
-			return 0;
-	}
-	if (obj->opcode2) {
-		args.pge = live_pge;
-		args.a = obj->opcode_arg2;
-		args.b = obj->opcode_arg1;
-		debug(DBG_PGE, "pge_execute op2=0x%X", obj->opcode2);
-		op = _pge_opcodeTable[obj->opcode2];
-		if (!op) {
-			warning("Game::pge_execute() missing call to pge_opcode 0x%X", obj->opcode2);
-			return 0;
-		}
-		if (!((this->*op)(&args) & 0xFF))
-			return 0;
 	}
-	if (obj->opcode3) {
-		args.pge = live_pge;
-		args.a = obj->opcode_arg3;
-		args.b = 0;
-		debug(DBG_PGE, "pge_execute op3=0x%X", obj->opcode3);
-		op = _pge_opcodeTable[obj->opcode3];
-		if (op) {
-			(this->*op)(&args);
-		} else {
-			warning("Game::pge_execute() missing call to pge_opcode 0x%X", obj->opcode3);
-		}
+	if (code->flags & kObjectCodeAbort) {
+		return 0;
 	}
-	live_pge->obj_type = obj->init_obj_type;
+	pge_objType(live_pge) = obj->init_obj_type;
 	live_pge->first_obj_number = obj->init_obj_number;
-	live_pge->anim_seq = 0;
+	pge_animSeq(live_pge) = 0;
 	if (obj->flags & 0xF0) {
 		_score += _scoreTable[obj->flags >> 4];
 	}
 	if (obj->flags & 1) {
-		live_pge->flags ^= 1;
+		pge_flags(live_pge) ^= 1;
 	}
 	if (obj->flags & 2) {
 		--live_pge->life;
@@ -319,12 +324,12 @@ int Game::pge_execute(LivePGE *live_pge, InitPGE *init_pge, const Object *obj) {
 		live_pge->life = 0xFFFF;
 	}
 
-	if (live_pge->flags & 1) {
-		live_pge->pos_x -= obj->dx;
+	if (pge_flags(live_pge) & 1) {
+		pge_posX(live_pge) -= obj->dx;
 	} else {
-		live_pge->pos_x += obj->dx;
+		pge_posX(live_pge) += obj->dx;
 	}
-	live_pge->pos_y += obj->dy;
+	pge_posY(live_pge) += obj->dy;
 
 	if (_pge_processOBJ) {
 		if (init_pge->object_type == 1) {
@@ -337,48 +342,95 @@ int Game::pge_execute(LivePGE *live_pge, InitPGE *init_pge, const Object *obj) {
 	return 0xFFFF;
 }
 
+int Game::pge_profileOpcode(uint8_t num, ObjectOpcodeArgs *args) {
+	OpcodeStats *&stats = _profileStats[MIN(_currentLevel, kProfileLevels - 1)][_currentRoom];
+	if (!stats) {
+		stats = (OpcodeStats *)calloc(_pge_opcodeTableSize, sizeof(OpcodeStats));
+		if (!stats) {
+			error("Unable to allocate opcode stats");
+		}
+	}
+	OpcodeStats *s = &stats[num];
+	const uint64_t t = getTimeNs();
+	const int ret = (this->*_pge_opcodeTable[num])(args);
+	s->time += getTimeNs() - t;
+	++s->calls;
+	if (ret & 0xFF) {
+		++s->success;
+	}
+	return ret;
+}
+
 void Game::pge_prepare() {
 	col_clearState();
 	if (!(_currentRoom & 0x80)) {
 		LivePGE *pge = _pge_liveTable1[_currentRoom];
 		while (pge) {
 			col_preparePiegeState(pge);
-			if (!(pge->flags & 4) && (pge->init_PGE->flags & 4)) {
-				_pge_liveTable2[pge->index] = pge;
-				pge->flags |= 4;
+			if (!(pge_flags(pge) & 4) && (pge->init_PGE->flags & 4)) {
+				pge_activate(pge);
+				pge_flags(pge) |= 4;
 			}
 			pge = pge->next_PGE_in_room;
 		}
 	}
-	for (uint16_t i = 0; i < _res._pgeNum; ++i) {
-		LivePGE *pge = _pge_liveTable2[i];
-		if (pge && _currentRoom != pge->room_location) {
+	for (int i = pge_getNextActive(0); i >= 0 && i < _res._pgeNum; i = pge_getNextActive(i + 1)) {
+		LivePGE *pge = &_pgeLive[i];
+		if (_currentRoom != pge_roomLocation(pge)) {
 			col_preparePiegeState(pge);
 		}
 	}
 }
 
+void Game::pge_clearActive() {
+	memset(_pge_activeMask, 0, sizeof(_pge_activeMask));
+}
+
+void Game::pge_activate(LivePGE *pge) {
+	_pge_activeMask[pge->index >> 5] |= 1U << (pge->index & 31);
+}
+
+void Game::pge_deactivate(LivePGE *pge) {
+	_pge_activeMask[pge->index >> 5] &= ~(1U << (pge->index & 31));
+}
+
+int Game::pge_getNextActive(int num) const {
+	int i = num >> 5;
+	if (i >= ARRAYSIZE(_pge_activeMask)) {
+		return -1;
+	}
+	uint32_t mask = _pge_activeMask[i] & (0xFFFFFFFF << (num & 31));
+	while (mask == 0) {
+		++i;
+		if (i >= ARRAYSIZE(_pge_activeMask)) {
+			return -1;
+		}
+		mask = _pge_activeMask[i];
+	}
+	return (i << 5) + findFirstBitSet(mask);
+}
+
 void Game::pge_setupDefaultAnim(LivePGE *pge) {
-	const uint8_t *anim_data = _res.getAniData(pge->obj_type);
-	if (pge->anim_seq < _res._readUint16(anim_data)) {
-		pge->anim_seq = 0;
+	const uint8_t *anim_data = _res.getAniData(pge_objType(pge));
+	if (pge_animSeq(pge) < _res._readUint16(anim_data)) {
+		pge_animSeq(pge) = 0;
 	}
-	const uint8_t *anim_frame = anim_data + 6 + pge->anim_seq * 4;
+	const uint8_t *anim_frame = anim_data + 6 + pge_animSeq(pge) * 4;
 	if (_res._readUint16(anim_frame) != 0xFFFF) {
 		uint16_t f = _res._readUint16(anim_data);
-		if (pge->flags & 1) {
+		if (pge_flags(pge) & 1) {
 			f ^= 0x8000;
 		}
-		pge->flags &= ~2;
+		pge_flags(pge) &= ~2;
 		if (f & 0x8000) {
-			pge->flags |= 2;
+			pge_flags(pge) |= 2;
 		}
-		pge->flags &= ~8;
+		pge_flags(pge) &= ~8;
 		if (_res._readUint16(anim_data + 4) & 0xFFFF) {
-			pge->flags |= 8;
+			pge_flags(pge) |= 8;
 		}
 		pge->anim_number = _res._readUint16(anim_frame) & 0x7FFF;
-		debug(DBG_PGE, "Game::pge_setupDefaultAnim() pgeNum=%ld pge->flags=0x%X pge->anim_number=0x%X pge->anim_seq=0x%X", pge - &_pgeLive[0], pge->flags, pge->anim_number, pge->anim_seq);
+		debug(DBG_PGE, "Game::pge_setupDefaultAnim() pgeNum=%ld pge->flags=0x%X pge->anim_number=0x%X pge->anim_seq=0x%X", pge - &_pgeLive[0], pge_flags(pge), pge->anim_number, pge_animSeq(pge));
 	}
 }
 
@@ -386,41 +438,35 @@ uint16_t Game::pge_processOBJ(LivePGE *pge) {
 	InitPGE *init_pge = pge->init_PGE;
 	assert(init_pge->obj_node_number < _res._numObjectNodes);
 	ObjectNode *on = _res._objectNodesMap[init_pge->obj_node_number];
-	Object *obj = &on->objects[pge->first_obj_number];
-	int i = pge->first_obj_number;
-	while (i < on->last_obj_number && pge->obj_type == obj->type) {
-		if (obj->opcode2 == 0x6B) return 0xFFFF;
-		if (obj->opcode2 == 0x22 && obj->opcode_arg2 <= 4) return 0xFFFF;
-
-		if (obj->opcode1 == 0x6B) return 0xFFFF;
-		if (obj->opcode1 == 0x22 && obj->opcode_arg1 <= 4) return 0xFFFF;
-
-		++obj;
-		++i;
+	const int i = pge->first_obj_number;
+	if (i < on->last_obj_number && pge_objType(pge) == on->objects[i].type) {
+		if (on->code[i].flags & kObjectCodeChainGroupSlice) {
+			return 0xFFFF;
+		}
 	}
 	return 0;
 }
 
 void Game::pge_setupOtherPieges(LivePGE *pge, InitPGE *init_pge) {
 	const int8_t *room_ct_data = 0;
-	if (pge->pos_x <= -10) {
-		pge->pos_x += 256;
+	if (pge_posX(pge) <= -10) {
+		pge_posX(pge) += 256;
 		room_ct_data = &_res._ctData[CT_LEFT_ROOM];
-	} else if (pge->pos_x >= 256) {
-		pge->pos_x -= 256;
+	} else if (pge_posX(pge) >= 256) {
+		pge_posX(pge) -= 256;
 		room_ct_data = &_res._ctData[CT_RIGHT_ROOM];
-	} else if (pge->pos_y < 0) {
-		pge->pos_y += 216;
+	} else if (pge_posY(pge) < 0) {
+		pge_posY(pge) += 216;
 		room_ct_data = &_res._ctData[CT_UP_ROOM];
-	} else if (pge->pos_y >= 216) {
-		pge->pos_y -= 216;
+	} else if (pge_posY(pge) >= 216) {
+		pge_posY(pge) -= 216;
 		room_ct_data = &_res._ctData[CT_DOWN_ROOM];
 	}
 	if (room_ct_data) {
-		int8_t room = pge->room_location;
+		int8_t room = pge_roomLocation(pge);
 		if (room >= 0) {
 			room = room_ct_data[room];
-			pge->room_location = room;
+			pge_roomLocation(pge) = room;
 		}
 		if (init_pge->object_type == 1) {
 			_currentRoom = room;
@@ -430,8 +476,8 @@ void Game::pge_setupOtherPieges(LivePGE *pge, InitPGE *init_pge) {
 				LivePGE *pge_it = _pge_liveTable1[_currentRoom];
 				while (pge_it) {
 					if (pge_it->init_PGE->flags & 4) {
-						_pge_liveTable2[pge_it->index] = pge_it;
-						pge_it->flags |= 4;
+						pge_activate(pge_it);
+						pge_flags(pge_it) |= 4;
 					}
 					pge_it = pge_it->next_PGE_in_room;
 				}
@@ -439,9 +485,9 @@ void Game::pge_setupOtherPieges(LivePGE *pge, InitPGE *init_pge) {
 				if (room >= 0 && room < 0x40) {
 					pge_it = _pge_liveTable1[room];
 					while (pge_it) {
-						if (pge_it->init_PGE->object_type != 10 && pge_it->pos_y >= 48 && (pge_it->init_PGE->flags & 4)) {
-							_pge_liveTable2[pge_it->index] = pge_it;
-							pge_it->flags |= 4;
+						if (pge_it->init_PGE->object_type != 10 && pge_posY(pge_it) >= 48 && (pge_it->init_PGE->flags & 4)) {
+							pge_activate(pge_it);
+							pge_flags(pge_it) |= 4;
 						}
 						pge_it = pge_it->next_PGE_in_room;
 					}
@@ -450,9 +496,9 @@ void Game::pge_setupOtherPieges(LivePGE *pge, InitPGE *init_pge) {
 				if (room >= 0 && room < 0x40) {
 					pge_it = _pge_liveTable1[room];
 					while (pge_it) {
-						if (pge_it->init_PGE->object_type != 10 && pge_it->pos_y >= 176 && (pge_it->init_PGE->flags & 4)) {
-							_pge_liveTable2[pge_it->index] = pge_it;
-							pge_it->flags |= 4;
+						if (pge_it->init_PGE->object_type != 10 && pge_posY(pge_it) >= 176 && (pge_it->init_PGE->flags & 4)) {
+							pge_activate(pge_it);
+							pge_flags(pge_it) |= 4;
 						}
 						pge_it = pge_it->next_PGE_in_room;
 					}
@@ -465,7 +511,7 @@ void Game::pge_setupOtherPieges(LivePGE *pge, InitPGE *init_pge) {
 
 void Game::pge_addToCurrentRoomList(LivePGE *pge, uint8_t room) {
 	debug(DBG_PGE, "Game::pge_addToCurrentRoomList() pgeNum=%ld room=%d", pge - &_pgeLive[0], room);
-	if (room != pge->room_location) {
+	if (room != pge_roomLocation(pge)) {
 		LivePGE *cur_pge = _pge_liveTable1[room];
 		LivePGE *prev_pge = 0;
 		while (cur_pge && cur_pge != pge) {
@@ -478,9 +524,9 @@ void Game::pge_addToCurrentRoomList(LivePGE *pge, uint8_t room) {
 			} else {
 				prev_pge->next_PGE_in_room = cur_pge->next_PGE_in_room;
 			}
-			LivePGE *temp = _pge_liveTable1[pge->room_location];
+			LivePGE *temp = _pge_liveTable1[pge_roomLocation(pge)];
 			pge->next_PGE_in_room = temp;
-			_pge_liveTable1[pge->room_location] = pge;
+			_pge_liveTable1[pge_roomLocation(pge)] = pge;
 		}
 	}
 }
@@ -887,7 +933,7 @@ int Game::pge_op_pickupObject(ObjectOpcodeArgs *args) {
 
 int Game::pge_op_addItemToInventory(ObjectOpcodeArgs *args) {
 	pge_updateInventory(&_pgeLive[args->a], args->pge);
-	args->pge->room_location = 0xFF;
+	pge_roomLocation(args->pge) = 0xFF;
 	return 0xFFFF;
 }
 
@@ -895,13 +941,13 @@ int Game::pge_op_copyPiege(ObjectOpcodeArgs *args) {
 	LivePGE *src = &_pgeLive[args->a];
 	LivePGE *dst = args->pge;
 
-	dst->pos_x = src->pos_x;
-	dst->pos_y = src->pos_y;
-	dst->room_location = src->room_location;
+	pge_posX(dst) = pge_posX(src);
+	pge_posY(dst) = pge_posY(src);
+	pge_roomLocation(dst) = pge_roomLocation(src);
 
-	dst->flags &= 0xFE;
-	if (src->flags & 1) {
-		dst->flags |= 1;
+	pge_flags(dst) &= 0xFE;
+	if (pge_flags(src) & 1) {
+		pge_flags(dst) |= 1;
 	}
 	pge_reorderInventory(args->pge);
 	return 0xFFFF;
@@ -990,7 +1036,7 @@ int Game::pge_op_decPiegeCounter(ObjectOpcodeArgs *args) {
 }
 
 int Game::pge_o_unk0x40(ObjectOpcodeArgs *args) {
-	int8_t pge_room = args->pge->room_location;
+	int8_t pge_room = pge_roomLocation(args->pge);
 	if (pge_room < 0 || pge_room >= 0x40) return 0;
 	int col_area;
 	if (_currentRoom == pge_room) {
@@ -1002,8 +1048,8 @@ int Game::pge_o_unk0x40(ObjectOpcodeArgs *args) {
 	} else {
 		return 0;
 	}
-	int16_t grid_pos_x = (args->pge->pos_x + 8) >> 4;
-	int16_t grid_pos_y = args->pge->pos_y / 72;
+	int16_t grid_pos_x = (pge_posX(args->pge) + 8) >> 4;
+	int16_t grid_pos_y = pge_posY(args->pge) / 72;
 	if (grid_pos_y >= 0 && grid_pos_y <= 2) {
 		grid_pos_y *= 16;
 		int16_t _cx = args->a;
@@ -1035,7 +1081,7 @@ int Game::pge_o_unk0x40(ObjectOpcodeArgs *args) {
 				if (_bl >= 0) {
 					CollisionSlot *col_slot = _col_slotsTable[_bl];
 					do {
-						if (args->pge != col_slot->live_pge && (col_slot->live_pge->flags & 4)) {
+						if (args->pge != col_slot->live_pge && (pge_flags(col_slot->live_pge) & 4)) {
 							if (col_slot->live_pge->init_PGE->object_type == args->b) {
 								return 1;
 							}
@@ -1073,7 +1119,7 @@ int Game::pge_o_unk0x40(ObjectOpcodeArgs *args) {
 				if (_bl >= 0) {
 					CollisionSlot *col_slot = _col_slotsTable[_bl];
 					do {
-						if (args->pge != col_slot->live_pge && (col_slot->live_pge->flags & 4)) {
+						if (args->pge != col_slot->live_pge && (pge_flags(col_slot->live_pge) & 4)) {
 							if (col_slot->live_pge->init_PGE->object_type == args->b) {
 								return 1;
 							}
@@ -1096,8 +1142,8 @@ int Game::pge_op_wakeUpPiege(ObjectOpcodeArgs *args) {
 		int16_t num = args->pge->init_PGE->counter_values[args->a];
 		if (num >= 0) {
 			LivePGE *pge = &_pgeLive[num];
-			pge->flags |= 4;
-			_pge_liveTable2[num] = pge;
+			pge_flags(pge) |= 4;
+			pge_activate(pge);
 		}
 	}
 	return 1;
@@ -1107,8 +1153,8 @@ int Game::pge_op_removePiege(ObjectOpcodeArgs *args) {
 	if (args->a <= 3) {
 		int16_t num = args->pge->init_PGE->counter_values[args->a];
 		if (num >= 0) {
-			_pge_liveTable2[num] = 0;
-			_pgeLive[num].flags &= ~4;
+			pge_deactivate(&_pgeLive[num]);
+			_pgeHot.flags[num] &= ~4;
 		}
 	}
 	return 1;
@@ -1118,18 +1164,18 @@ int Game::pge_op_removePiegeIfNotNear(ObjectOpcodeArgs *args) {
 	LivePGE *pge = args->pge;
 	if (!(pge->init_PGE->flags & 4)) goto kill_pge;
 	if (_currentRoom & 0x80) goto skip_pge;
-	if (pge->room_location & 0x80) goto kill_pge;
-	if (pge->room_location > 0x3F) goto kill_pge;
-	if (pge->room_location == _currentRoom) goto skip_pge;
-	if (pge->room_location == _res._ctData[CT_UP_ROOM + _currentRoom]) goto skip_pge;
-	if (pge->room_location == _res._ctData[CT_DOWN_ROOM + _currentRoom]) goto skip_pge;
-	if (pge->room_location == _res._ctData[CT_RIGHT_ROOM + _currentRoom]) goto skip_pge;
-	if (pge->room_location == _res._ctData[CT_LEFT_ROOM + _currentRoom]) goto skip_pge;
+	if (pge_roomLocation(pge) & 0x80) goto kill_pge;
+	if (pge_roomLocation(pge) > 0x3F) goto kill_pge;
+	if (pge_roomLocation(pge) == _currentRoom) goto skip_pge;
+	if (pge_roomLocation(pge) == _res._ctData[CT_UP_ROOM + _currentRoom]) goto skip_pge;
+	if (pge_roomLocation(pge) == _res._ctData[CT_DOWN_ROOM + _currentRoom]) goto skip_pge;
+	if (pge_roomLocation(pge) == _res._ctData[CT_RIGHT_ROOM + _currentRoom]) goto skip_pge;
+	if (pge_roomLocation(pge) == _res._ctData[CT_LEFT_ROOM + _currentRoom]) goto skip_pge;
 
 kill_pge:
-	pge->flags &= ~4;
+	pge_flags(pge) &= ~4;
 	pge->collision_slot = 0xFF;
-	_pge_liveTable2[pge->index] = 0;
+	pge_deactivate(pge);
 
 skip_pge:
 	_pge_playAnimSound = false;
@@ -1173,9 +1219,9 @@ int Game::pge_o_unk0x49(ObjectOpcodeArgs *args) {
 
 int Game::pge_o_unk0x4A(ObjectOpcodeArgs *args) {
 	LivePGE *pge = args->pge;
-	pge->room_location = 0xFE;
-	pge->flags &= ~4;
-	_pge_liveTable2[pge->index] = 0;
+	pge_roomLocation(pge) = 0xFE;
+	pge_flags(pge) &= ~4;
+	pge_deactivate(pge);
 	LivePGE *inv_pge = pge_getInventoryItemBefore(&_pgeLive[args->a], pge);
 	if (inv_pge == &_pgeLive[args->a]) {
 		if (pge->index != inv_pge->current_inventory_PGE) {
@@ -1192,9 +1238,9 @@ int Game::pge_o_unk0x4A(ObjectOpcodeArgs *args) {
 
 int Game::pge_op_killPiege(ObjectOpcodeArgs *args) {
 	LivePGE *pge = args->pge;
-	pge->room_location = 0xFE;
-	pge->flags &= ~4;
-	_pge_liveTable2[pge->index] = 0;
+	pge_roomLocation(pge) = 0xFE;
+	pge_flags(pge) &= ~4;
+	pge_deactivate(pge);
 	if (pge->init_PGE->object_type == 10) {
 		_score += 200;
 	}
@@ -1202,20 +1248,20 @@ int Game::pge_op_killPiege(ObjectOpcodeArgs *args) {
 }
 
 int Game::pge_op_isInCurrentRoom(ObjectOpcodeArgs *args) {
-	return (args->pge->room_location == _currentRoom) ? 1 : 0;
+	return (pge_roomLocation(args->pge) == _currentRoom) ? 1 : 0;
 }
 
 int Game::pge_op_isNotInCurrentRoom(ObjectOpcodeArgs *args) {
-	return (args->pge->room_location == _currentRoom) ? 0 : 1;
+	return (pge_roomLocation(args->pge) == _currentRoom) ? 0 : 1;
 }
 
 int Game::pge_op_scrollPosY(ObjectOpcodeArgs *args) {
 	LivePGE *pge = args->pge;
-	args->pge->pos_y += args->a;
+	pge_posY(args->pge) += args->a;
 	uint8_t pge_num = pge->current_inventory_PGE;
 	while (pge_num != 0xFF) {
 		pge = &_pgeLive[pge_num];
-		pge->pos_y += args->a;
+		pge_posY(pge) += args->a;
 		pge_num = pge->next_inventory_PGE;
 	}
 	return 1;
@@ -1261,7 +1307,7 @@ int Game::pge_op_incLife(ObjectOpcodeArgs *args) {
 int Game::pge_op_setPiegeDefaultAnim(ObjectOpcodeArgs *args) {
 	assert(args->a >= 0 && args->a < 4);
 	int16_t r = args->pge->init_PGE->counter_values[args->a];
-	args->pge->room_location = r;
+	pge_roomLocation(args->pge) = r;
 	if (r == 1) {
 		// this happens after death tower, on earth, when Conrad passes
 		// by the first policeman who's about to shoot him in the back
@@ -1314,7 +1360,7 @@ int Game::pge_o_unk0x5E(ObjectOpcodeArgs *args) {
 int Game::pge_o_unk0x5F(ObjectOpcodeArgs *args) {
 	LivePGE *pge = args->pge;
 
-	int8_t pge_room = pge->room_location;
+	int8_t pge_room = pge_roomLocation(pge);
 	if (pge_room < 0 || pge_room >= 0x40) return 0;
 
 	int16_t dx;
@@ -1328,14 +1374,14 @@ int Game::pge_o_unk0x5F(ObjectOpcodeArgs *args) {
 	if (_pge_currentPiegeFacingDir) {
 		dx = -dx;
 	}
-	int16_t grid_pos_x = (pge->pos_x + 8) >> 4;
+	int16_t grid_pos_x = (pge_posX(pge) + 8) >> 4;
 	int16_t grid_pos_y = 0;
 	do {
 		int16_t _ax = col_getGridData(pge, 1, -grid_pos_y);
 		if (_ax != 0) {
 			if (!(_ax & 2) || args->a != 1) {
-				pge->room_location = pge_room;
-				pge->pos_x = grid_pos_x * 16;
+				pge_roomLocation(pge) = pge_room;
+				pge_posX(pge) = grid_pos_x * 16;
 				return 1;
 			}
 		}
@@ -1426,7 +1472,7 @@ int Game::pge_op_saveState(ObjectOpcodeArgs *args) {
 // useGun related
 int Game::pge_o_unk0x6A(ObjectOpcodeArgs *args) {
 	LivePGE *_si = args->pge;
-	int8_t pge_room = _si->room_location;
+	int8_t pge_room = pge_roomLocation(_si);
 	if (pge_room < 0 || pge_room >= 0x40) return 0;
 	int8_t _bl;
 	int col_area = 0;
@@ -1440,8 +1486,8 @@ int Game::pge_o_unk0x6A(ObjectOpcodeArgs *args) {
 	} else {
 		return 0;
 	}
-	int16_t grid_pos_x = (_si->pos_x + 8) >> 4;
-	int16_t grid_pos_y = (_si->pos_y / 72);
+	int16_t grid_pos_x = (pge_posX(_si) + 8) >> 4;
+	int16_t grid_pos_y = (pge_posY(_si) / 72);
 	if (grid_pos_y >= 0 && grid_pos_y <= 2) {
 		grid_pos_y *= 16;
 		int16_t _cx = args->a;
@@ -1474,7 +1520,7 @@ int Game::pge_o_unk0x6A(ObjectOpcodeArgs *args) {
 					CollisionSlot *collision_slot = _col_slotsTable[_bl];
 					do {
 						_si = collision_slot->live_pge;
-						if (args->pge != _si && (_si->flags & 4) && _si->life >= 0) {
+						if (args->pge != _si && (pge_flags(_si) & 4) && _si->life >= 0) {
 							if (_si->init_PGE->object_type == 1 || _si->init_PGE->object_type == 10) {
 								return 1;
 							}
@@ -1514,7 +1560,7 @@ loc_0_15446:
 					CollisionSlot *collision_slot = _col_slotsTable[_bl];
 					do {
 						_si = collision_slot->live_pge;
-						if (args->pge != _si && (_si->flags & 4) && _si->life >= 0) {
+						if (args->pge != _si && (pge_flags(_si) & 4) && _si->life >= 0) {
 							if (_si->init_PGE->object_type == 1 || _si->init_PGE->object_type == 10) {
 								return 1;
 							}
@@ -1626,8 +1672,8 @@ int Game::pge_o_unk0x71(ObjectOpcodeArgs *args) {
 }
 
 int Game::pge_o_unk0x72(ObjectOpcodeArgs *args) {
-	int8_t *var4 = &_res._ctData[0x100] + args->pge->room_location * 0x70;
-	var4 += (((args->pge->pos_y / 36) & ~1) + args->a) * 16 + (args->pge->pos_x + 8) / 16;
+	int8_t *var4 = &_res._ctData[0x100] + pge_roomLocation(args->pge) * 0x70;
+	var4 += (((pge_posY(args->pge) / 36) & ~1) + args->a) * 16 + (pge_posX(args->pge) + 8) / 16;
 
 	CollisionSlot2 *_di = _col_slots2Next;
 	int _cx = 0x100;
@@ -1669,12 +1715,12 @@ int Game::pge_op_doesNotCollide4u(ObjectOpcodeArgs *args) {
 int Game::pge_op_isBelowConrad(ObjectOpcodeArgs *args) {
 	LivePGE *_si = args->pge;
 	LivePGE *pge_conrad = &_pgeLive[0];
-	if (pge_conrad->room_location == _si->room_location) {
-		if ((pge_conrad->pos_y - 8) / 72 < _si->pos_y / 72) {
+	if (pge_roomLocation(pge_conrad) == pge_roomLocation(_si)) {
+		if ((pge_posY(pge_conrad) - 8) / 72 < pge_posY(_si) / 72) {
 			return 0xFFFF;
 		}
-	} else if (!(_si->room_location & 0x80) && _si->room_location < 0x40) {
-		if (pge_conrad->room_location == _res._ctData[CT_UP_ROOM + _si->room_location]) {
+	} else if (!(pge_roomLocation(_si) & 0x80) && pge_roomLocation(_si) < 0x40) {
+		if (pge_roomLocation(pge_conrad) == _res._ctData[CT_UP_ROOM + pge_roomLocation(_si)]) {
 			return 0xFFFF;
 		}
 	}
@@ -1684,12 +1730,12 @@ int Game::pge_op_isBelowConrad(ObjectOpcodeArgs *args) {
 int Game::pge_op_isAboveConrad(ObjectOpcodeArgs *args) {
 	LivePGE *_si = args->pge;
 	LivePGE *pge_conrad = &_pgeLive[0];
-	if (pge_conrad->room_location == _si->room_location) {
-		if ((pge_conrad->pos_y - 8) / 72 > _si->pos_y / 72) {
+	if (pge_roomLocation(pge_conrad) == pge_roomLocation(_si)) {
+		if ((pge_posY(pge_conrad) - 8) / 72 > pge_posY(_si) / 72) {
 			return 0xFFFF;
 		}
-	} else if (!(_si->room_location & 0x80) && _si->room_location < 0x40) {
-		if (pge_conrad->room_location == _res._ctData[CT_DOWN_ROOM + _si->room_location]) {
+	} else if (!(pge_roomLocation(_si) & 0x80) && pge_roomLocation(_si) < 0x40) {
+		if (pge_roomLocation(pge_conrad) == _res._ctData[CT_DOWN_ROOM + pge_roomLocation(_si)]) {
 			return 0xFFFF;
 		}
 	}
@@ -1699,36 +1745,36 @@ int Game::pge_op_isAboveConrad(ObjectOpcodeArgs *args) {
 int Game::pge_op_isNotFacingConrad(ObjectOpcodeArgs *args) {
 	LivePGE *pge = args->pge;
 	LivePGE *pge_conrad = &_pgeLive[0];
-	if (pge->pos_y / 72 == (pge_conrad->pos_y - 8) / 72) { // same grid cell
-		if (pge->room_location == pge_conrad->room_location) {
+	if (pge_posY(pge) / 72 == (pge_posY(pge_conrad) - 8) / 72) { // same grid cell
+		if (pge_roomLocation(pge) == pge_roomLocation(pge_conrad)) {
 			if (args->a == 0) {
 				if (_pge_currentPiegeFacingDir) {
-					if (pge->pos_x < pge_conrad->pos_x) {
+					if (pge_posX(pge) < pge_posX(pge_conrad)) {
 						return 0xFFFF;
 					}
 				} else {
-					if (pge->pos_x > pge_conrad->pos_x) {
+					if (pge_posX(pge) > pge_posX(pge_conrad)) {
 						return 0xFFFF;
 					}
 				}
 			} else {
 				int16_t dx;
 				if (_pge_currentPiegeFacingDir) {
-					dx = pge_conrad->pos_x - pge->pos_x;
+					dx = pge_posX(pge_conrad) - pge_posX(pge);
 				} else {
-					dx = pge->pos_x - pge_conrad->pos_x;
+					dx = pge_posX(pge) - pge_posX(pge_conrad);
 				}
 				if (dx > 0 && dx < args->a * 16) {
 					return 0xFFFF;
 				}
 			}
 		} else if (args->a == 0) {
-			if (!(pge->room_location & 0x80) && pge->room_location < 0x40) {
+			if (!(pge_roomLocation(pge) & 0x80) && pge_roomLocation(pge) < 0x40) {
 				if (_pge_currentPiegeFacingDir) {
-					if (pge_conrad->room_location == _res._ctData[CT_RIGHT_ROOM + pge->room_location])
+					if (pge_roomLocation(pge_conrad) == _res._ctData[CT_RIGHT_ROOM + pge_roomLocation(pge)])
 						return 0xFFFF;
 				} else {
-					if (pge_conrad->room_location == _res._ctData[CT_LEFT_ROOM + pge->room_location])
+					if (pge_roomLocation(pge_conrad) == _res._ctData[CT_LEFT_ROOM + pge_roomLocation(pge)])
 						return 0xFFFF;
 				}
 			}
@@ -1740,36 +1786,36 @@ int Game::pge_op_isNotFacingConrad(ObjectOpcodeArgs *args) {
 int Game::pge_op_isFacingConrad(ObjectOpcodeArgs *args) {
 	LivePGE *pge = args->pge;
 	LivePGE *pge_conrad = &_pgeLive[0];
-	if (pge->pos_y / 72 == (pge_conrad->pos_y - 8) / 72) {
-		if (pge->room_location == pge_conrad->room_location) {
+	if (pge_posY(pge) / 72 == (pge_posY(pge_conrad) - 8) / 72) {
+		if (pge_roomLocation(pge) == pge_roomLocation(pge_conrad)) {
 			if (args->a == 0) {
 				if (_pge_currentPiegeFacingDir) {
-					if (pge->pos_x > pge_conrad->pos_x) {
+					if (pge_posX(pge) > pge_posX(pge_conrad)) {
 						return 0xFFFF;
 					}
 				} else {
-					if (pge->pos_x <= pge_conrad->pos_x) {
+					if (pge_posX(pge) <= pge_posX(pge_conrad)) {
 						return 0xFFFF;
 					}
 				}
 			} else {
 				int16_t dx;
 				if (_pge_currentPiegeFacingDir) {
-					dx = pge->pos_x - pge_conrad->pos_x;
+					dx = pge_posX(pge) - pge_posX(pge_conrad);
 				} else {
-					dx = pge_conrad->pos_x - pge->pos_x;
+					dx = pge_posX(pge_conrad) - pge_posX(pge);
 				}
 				if (dx > 0 && dx < args->a * 16) {
 					return 0xFFFF;
 				}
 			}
 		} else if (args->a == 0) {
-			if (!(pge->room_location & 0x80) && pge->room_location < 0x40) {
+			if (!(pge_roomLocation(pge) & 0x80) && pge_roomLocation(pge) < 0x40) {
 				if (_pge_currentPiegeFacingDir) {
-					if (pge_conrad->room_location == _res._ctData[CT_LEFT_ROOM + pge->room_location])
+					if (pge_roomLocation(pge_conrad) == _res._ctData[CT_LEFT_ROOM + pge_roomLocation(pge)])
 						return 0xFFFF;
 				} else {
-					if (pge_conrad->room_location == _res._ctData[CT_RIGHT_ROOM + pge->room_location])
+					if (pge_roomLocation(pge_conrad) == _res._ctData[CT_RIGHT_ROOM + pge_roomLocation(pge)])
 						return 0xFFFF;
 				}
 			}
@@ -1847,7 +1893,7 @@ int Game::pge_o_unk0x7F(ObjectOpcodeArgs *args) {
 int Game::pge_op_setPiegePosX(ObjectOpcodeArgs *args) {
 	uint8_t pge_num = args->pge->unkF;
 	if (pge_num != 0xFF) {
-		args->pge->pos_x = _pgeLive[pge_num].pos_x;
+		pge_posX(args->pge) = _pgeHot.pos_x[pge_num];
 	}
 	return 0xFFFF;
 }
@@ -1855,11 +1901,11 @@ int Game::pge_op_setPiegePosX(ObjectOpcodeArgs *args) {
 int Game::pge_op_setPiegePosModX(ObjectOpcodeArgs *args) {
 	uint8_t pge_num = args->pge->unkF;
 	if (pge_num != 0xFF) {
-		int16_t dx = _pgeLive[pge_num].pos_x % 256;
-		if (dx >= args->pge->pos_x) {
-			dx -= args->pge->pos_x;
+		int16_t dx = _pgeHot.pos_x[pge_num] % 256;
+		if (dx >= pge_posX(args->pge)) {
+			dx -= pge_posX(args->pge);
 		}
-		args->pge->pos_x += dx;
+		pge_posX(args->pge) += dx;
 	}
 	return 0xFFFF;
 }
@@ -1872,35 +1918,35 @@ int Game::pge_op_changeRoom(ObjectOpcodeArgs *args) {
 	int16_t _bx = init_pge_1->counter_values[args->a + 1];
 	LivePGE *live_pge_1 = &_pgeLive[_bx];
 	LivePGE *live_pge_2 = &_pgeLive[_ax];
-	int8_t pge_room = live_pge_1->room_location;
+	int8_t pge_room = pge_roomLocation(live_pge_1);
 	if (pge_room >= 0 && pge_room < 0x40) {
-		int8_t _al = live_pge_2->room_location;
-		live_pge_2->pos_x = live_pge_1->pos_x;
-		live_pge_2->pos_y = live_pge_1->pos_y;
-		live_pge_2->room_location = live_pge_1->room_location;
+		int8_t _al = pge_roomLocation(live_pge_2);
+		pge_posX(live_pge_2) = pge_posX(live_pge_1);
+		pge_posY(live_pge_2) = pge_posY(live_pge_1);
+		pge_roomLocation(live_pge_2) = pge_roomLocation(live_pge_1);
 		pge_addToCurrentRoomList(live_pge_2, _al);
 		InitPGE *init_pge_2 = live_pge_2->init_PGE;
 		init_pge_1 = live_pge_1->init_PGE;
 		if (init_pge_2->obj_node_number == init_pge_1->obj_node_number) {
-			live_pge_2->flags &= 0xFE;
-			if (live_pge_1->flags & 1) {
-				live_pge_2->flags |= 1;
+			pge_flags(live_pge_2) &= 0xFE;
+			if (pge_flags(live_pge_1) & 1) {
+				pge_flags(live_pge_2) |= 1;
 			}
-			live_pge_2->obj_type = live_pge_1->obj_type;
-			live_pge_2->anim_seq = 0;
+			pge_objType(live_pge_2) = pge_objType(live_pge_1);
+			pge_animSeq(live_pge_2) = 0;
 			assert(init_pge_2->obj_node_number < _res._numObjectNodes);
 			ObjectNode *on = _res._objectNodesMap[init_pge_2->obj_node_number];
 			Object *obj = on->objects;
 			int i = 0;
-			while (obj->type != live_pge_2->obj_type) {
+			while (obj->type != pge_objType(live_pge_2)) {
 				++i;
 				++obj;
 			}
 			live_pge_2->first_obj_number = i;
 		}
 		if (init_pge_2->object_type == 1) {
-			if (_currentRoom != live_pge_2->room_location) {
-				_currentRoom = live_pge_2->room_location;
+			if (_currentRoom != pge_roomLocation(live_pge_2)) {
+				_currentRoom = pge_roomLocation(live_pge_2);
 				loadLevelMap();
 				_vid.fullRefresh();
 			}
@@ -1949,9 +1995,9 @@ int Game::pge_op_playSoundGroup(ObjectOpcodeArgs *args) {
 
 int Game::pge_op_adjustPos(ObjectOpcodeArgs *args) {
 	LivePGE *pge = args->pge;
-	pge->pos_x &= 0xFFF0;
-	if (pge->pos_y != 70 && pge->pos_y != 142 && pge->pos_y != 214) {
-		pge->pos_y = ((pge->pos_y / 72) + 1) * 72 - 2;
+	pge_posX(pge) &= 0xFFF0;
+	if (pge_posY(pge) != 70 && pge_posY(pge) != 142 && pge_posY(pge) != 214) {
+		pge_posY(pge) = ((pge_posY(pge) / 72) + 1) * 72 - 2;
 	}
 	return 0xFFFF;
 }
@@ -2037,10 +2083,10 @@ void Game::pge_addToInventory(LivePGE *pge1, LivePGE *pge2, LivePGE *pge3) {
 
 int Game::pge_updateCollisionState(LivePGE *pge, int16_t pge_dy, uint8_t var8) {
 	uint8_t pge_unk1C = pge->init_PGE->unk1C;
-	if (!(pge->room_location & 0x80) && pge->room_location < 0x40) {
-		int8_t *grid_data = &_res._ctData[0x100] + 0x70 * pge->room_location;
-		int16_t pge_pos_y = ((pge->pos_y / 36) & ~1) + pge_dy;
-		int16_t pge_pos_x = (pge->pos_x + 8) >> 4;
+	if (!(pge_roomLocation(pge) & 0x80) && pge_roomLocation(pge) < 0x40) {
+		int8_t *grid_data = &_res._ctData[0x100] + 0x70 * pge_roomLocation(pge);
+		int16_t pge_pos_y = ((pge_posY(pge) / 36) & ~1) + pge_dy;
+		int16_t pge_pos_x = (pge_posX(pge) + 8) >> 4;
 
 		grid_data += pge_pos_x + pge_pos_y * 16;
 
@@ -2114,17 +2160,17 @@ int Game::pge_ZOrder(LivePGE *pge, int16_t num, pge_ZOrderCallback compare, uint
 void Game::pge_updateGroup(uint8_t idx, uint8_t unk1, int16_t unk2) {
 	debug(DBG_GAME, "Game::pge_updateGroup() idx=0x%X unk1=0x%X unk2=0x%X", idx, unk1, unk2);
 	LivePGE *pge = &_pgeLive[unk1];
-	if (!(pge->flags & 4)) {
+	if (!(pge_flags(pge) & 4)) {
 		if (!(pge->init_PGE->flags & 1)) {
 			return;
 		}
-		pge->flags |= 4;
-		_pge_liveTable2[unk1] = pge;
+		pge_flags(pge) |= 4;
+		pge_activate(pge);
 	}
 	if (unk2 <= 4) {
-		uint8_t pge_room = pge->room_location;
+		uint8_t pge_room = pge_roomLocation(pge);
 		pge = &_pgeLive[idx];
-		if (pge_room != pge->room_location) {
+		if (pge_room != pge_roomLocation(pge)) {
 			return;
 		}
 		if (unk1 == 0 && _blinkingConradCounter != 0) {
@@ -2157,7 +2203,7 @@ void Game::pge_removeFromInventory(LivePGE *pge1, LivePGE *pge2, LivePGE *pge3)
 
 int Game::pge_ZOrderByAnimY(LivePGE *pge1, LivePGE *pge2, uint8_t comp, uint8_t comp2) {
 	if (pge1 != pge2) {
-		if (_res.getAniData(pge1->obj_type)[3] == comp) {
+		if (_res.getAniData(pge_objType(pge1))[3] == comp) {
 			return 1;
 		}
 	}
@@ -2166,7 +2212,7 @@ int Game::pge_ZOrderByAnimY(LivePGE *pge1, LivePGE *pge2, uint8_t comp, uint8_t
 
 int Game::pge_ZOrderByAnimYIfType(LivePGE *pge1, LivePGE *pge2, uint8_t comp, uint8_t comp2) {
 	if (pge1->init_PGE->object_type == comp2) {
-		if (_res.getAniData(pge1->obj_type)[3] == comp) {
+		if (_res.getAniData(pge_objType(pge1))[3] == comp) {
 			return 1;
 		}
 	}
@@ -2204,7 +2250,7 @@ int Game::pge_ZOrderByObj(LivePGE *pge1, LivePGE *pge2, uint8_t comp, uint8_t co
 
 int Game::pge_ZOrderIfDifferentDirection(LivePGE *pge1, LivePGE *pge2, uint8_t comp, uint8_t comp2) {
 	if (pge1 != pge2) {
-		if ((pge1->flags & 1) != (pge2->flags & 1)) {
+		if ((pge_flags(pge1) & 1) != (pge_flags(pge2) & 1)) {
 			_pge_compareVar1 = 1;
 			pge_updateGroup(pge2->index, pge1->index, comp);
 			if (pge2->index == 0) {
@@ -2217,7 +2263,7 @@ int Game::pge_ZOrderIfDifferentDirection(LivePGE *pge1, LivePGE *pge2, uint8_t c
 
 int Game::pge_ZOrderIfSameDirection(LivePGE *pge1, LivePGE *pge2, uint8_t comp, uint8_t comp2) {
 	if (pge1 != pge2) {
-		if ((pge1->flags & 1) == (pge2->flags & 1)) {
+		if ((pge_flags(pge1) & 1) == (pge_flags(pge2) & 1)) {
 			_pge_compareVar2 = 1;
 			pge_updateGroup(pge2->index, pge1->index, comp);
 			if (pge2->index == 0) {
@@ -2230,7 +2276,7 @@ int Game::pge_ZOrderIfSameDirection(LivePGE *pge1, LivePGE *pge2, uint8_t comp,
 
 int Game::pge_ZOrderIfTypeAndSameDirection(LivePGE *pge1, LivePGE *pge2, uint8_t comp, uint8_t comp2) {
 	if (pge1->init_PGE->object_type == comp) {
-		if ((pge1->flags & 1) == (pge2->flags & 1)) {
+		if ((pge_flags(pge1) & 1) == (pge_flags(pge2) & 1)) {
 			return 1;
 		}
 	}
@@ -2239,7 +2285,7 @@ int Game::pge_ZOrderIfTypeAndSameDirection(LivePGE *pge1, LivePGE *pge2, uint8_t
 
 int Game::pge_ZOrderIfTypeAndDifferentDirection(LivePGE *pge1, LivePGE *pge2, uint8_t comp, uint8_t comp2) {
 	if (pge1->init_PGE->object_type == comp) {
-		if ((pge1->flags & 1) != (pge2->flags & 1)) {
+		if ((pge_flags(pge1) & 1) != (pge_flags(pge2) & 1)) {
 			return 1;
 		}
 	}
@@ -835,6 +835,7 @@ void Resource::load_OBJ(File *f) {
 				obj->opcode_arg3 = f->readUint16LE();
 				debug(DBG_RES, "obj_node=%d obj=%d op1=0x%X op2=0x%X op3=0x%X", i, j, obj->opcode2, obj->opcode1, obj->opcode3);
 			}
+			compileOBJ(on);
 			++iObj;
 			prevOffset = offsets[i];
 			prevNode = on;
@@ -850,6 +851,7 @@ void Resource::free_OBJ() {
 		if (_objectNodesMap[i] != prevNode) {
 			ObjectNode *curNode = _objectNodesMap[i];
 			free(curNode->objects);
+			free(curNode->code);
 			free(curNode);
 			prevNode = curNode;
 		}
@@ -925,6 +927,7 @@ void Resource::decodeOBJ(const uint8_t *tmp, int size) {
 				obj->opcode_arg3 = _readUint16(objData); objData += 2;
 				debug(DBG_RES, "obj_node=%d obj=%d op1=0x%X op2=0x%X op3=0x%X", i, j, obj->opcode2, obj->opcode1, obj->opcode3);
 			}
+			compileOBJ(on);
 			++iObj;
 			prevOffset = offsets[i];
 			prevNode = on;
@@ -933,6 +936,50 @@ void Resource::decodeOBJ(const uint8_t *tmp, int size) {
 	}
 }
 
+void Resource::compileOBJ(ObjectNode *on) {
+	on->code = (ObjectCode *)malloc(sizeof(ObjectCode) * on->num_objects);
+	if (!on->code && on->num_objects != 0) {
+		error("Unable to allocate ObjectCode num=%d", on->num_objects);
+	}
+	for (int j = on->num_objects - 1; j >= 0; --j) {
+		const Object *obj = &on->objects[j];
+		ObjectCode *code = &on->code[j];
+		// objects with the same type are tried in sequence until one succeeds
+		const bool chained = (j + 1 < on->num_objects && on->objects[j + 1].type == obj->type);
+		code->chain_end = chained ? on->code[j + 1].chain_end : j + 1;
+		code->num_ops = 0;
+		code->flags = 0;
+		if (obj->opcode1) {
+			ObjectOpcode *op = &code->ops[code->num_ops++];
+			op->num = obj->opcode1;
+			op->a = obj->opcode_arg1;
+			op->b = 0;
+		}
+		if (obj->opcode2) {
+			ObjectOpcode *op = &code->ops[code->num_ops++];
+			op->num = obj->opcode2;
+			op->a = obj->opcode_arg2;
+			op->b = obj->opcode_arg1;
+		}
+		code->num_conds = code->num_ops;
+		if (obj->opcode3) {
+			ObjectOpcode *op = &code->ops[code->num_ops++];
+			op->num = obj->opcode3;
+			op->a = obj->opcode_arg3;
+			op->b = 0;
+		}
+		if (obj->opcode2 == 0x6B || (obj->opcode2 == 0x22 && obj->opcode_arg2 <= 4) ||
+			obj->opcode1 == 0x6B || (obj->opcode1 == 0x22 && obj->opcode_arg1 <= 4)) {
+			code->flags |= kObjectCodeGroupSlice;
+		}
+		if (j < on->last_obj_number) {
+			if ((code->flags & kObjectCodeGroupSlice) || (chained && (on->code[j + 1].flags & kObjectCodeChainGroupSlice))) {
+				code->flags |= kObjectCodeChainGroupSlice;
+			}
+		}
+	}
+}
+
 void Resource::load_PGE(File *f) {
 	debug(DBG_RES, "Resource::load_PGE()");
 	if (_type == kResourceTypeAmiga) {
@@ -1289,6 +1336,7 @@ int Resource::getBankDataSize(uint16_t num) {
 uint8_t *Resource::findBankData(uint16_t num) {
 	for (int i = 0; i < _bankBuffersCount; ++i) {
 		if (_bankBuffers[i].entryNum == num) {
+			++_bankHits;
 			return _bankBuffers[i].ptr;
 		}
 	}
@@ -1303,6 +1351,7 @@ uint8_t *Resource::loadBankData(uint16_t num) {
 		// to the total count of entries
 		dataOffset &= 0xFFFF;
 	}
+	++_bankMisses;
 	const int size = getBankDataSize(num);
 	const int avail = _bankDataTail - _bankDataHead;
 	if (avail < size) {
@@ -148,6 +148,7 @@ struct Resource {
 	uint8_t *_bankDataTail;
 	BankSlot _bankBuffers[NUM_BANK_BUFFERS];
 	int _bankBuffersCount;
+	uint32_t _bankHits, _bankMisses;
 	uint8_t *_dem;
 	int _demLen;
 
@@ -186,6 +187,7 @@ struct Resource {
 	void free_OBJ();
 	void load_OBC(File *pf);
 	void decodeOBJ(const uint8_t *, int);
+	void compileOBJ(ObjectNode *on);
 	void load_PGE(File *pf);
 	void decodePGE(const uint8_t *, int);
 	void load_ANI(File *pf);
@@ -207,6 +209,9 @@ struct Resource {
 		return _tbn + _readUint16(_tbn + num * 2);
 	}
 	const uint8_t *getGameString(int num) {
+		if (!_stringsTable) {
+			load_TEXT();
+		}
 		return _stringsTable + READ_LE_UINT16(_stringsTable + num * 2);
 	}
 	const uint8_t *getCineString(int num) {
@@ -217,6 +222,9 @@ struct Resource {
 		return (num >= 0 && num < NUM_CUTSCENE_TEXTS) ? _cineStrings[num] : 0;
 	}
 	const char *getMenuString(int num) {
+		if (!_textsTable) {
+			load_TEXT();
+		}
 		return (num >= 0 && num < LocaleData::LI_NUM) ? _textsTable[num] : "";
 	}
 	void clearBankData();
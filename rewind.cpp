@@ -0,0 +1,168 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include "rewind.h"
+#include "util.h"
+
+static uint8_t *writeRunLength(uint8_t *p, uint32_t zeroCount, uint32_t literalCount) {
+	*p++ = zeroCount & 255;
+	*p++ = zeroCount >> 8;
+	*p++ = literalCount & 255;
+	*p++ = literalCount >> 8;
+	return p;
+}
+
+static uint32_t encodeState(const uint8_t *state, const uint8_t *ref, uint32_t size, uint8_t *dst) {
+	uint8_t *p = dst;
+	uint32_t i = 0;
+	while (i < size) {
+		uint32_t zeroCount = 0;
+		while (i < size && zeroCount < 0xFFFF && (state[i] ^ (ref ? ref[i] : 0)) == 0) {
+			++i;
+			++zeroCount;
+		}
+		// a literal run is interrupted by 4 unchanged bytes, the size of a new header
+		const uint32_t start = i;
+		uint32_t end = i;
+		for (uint32_t j = i; j < size && j - start < 0xFFFF; ++j) {
+			if ((state[j] ^ (ref ? ref[j] : 0)) != 0) {
+				end = j + 1;
+			} else if (j - end >= 4) {
+				break;
+			}
+		}
+		p = writeRunLength(p, zeroCount, end - start);
+		for (; i < end; ++i) {
+			*p++ = state[i] ^ (ref ? ref[i] : 0);
+		}
+	}
+	return p - dst;
+}
+
+RewindBuffer::RewindBuffer()
+	: _stateSize(0), _frames(0), _head(0), _count(0), _keyframesCount(0), _framesSinceKeyframe(0), _dataSize(0),
+	_keyframeState(0), _encodeBuf(0) {
+}
+
+bool RewindBuffer::init(uint32_t stateSize) {
+	_stateSize = stateSize;
+	_frames = (Frame *)calloc(kMaxFrames, sizeof(Frame));
+	_keyframeState = (uint8_t *)malloc(stateSize);
+	_encodeBuf = (uint8_t *)malloc(stateSize * 2 + 8);
+	if (!_frames || !_keyframeState || !_encodeBuf) {
+		fini();
+		return false;
+	}
+	return true;
+}
+
+void RewindBuffer::fini() {
+	if (_frames) {
+		clear();
+	}
+	free(_frames);
+	_frames = 0;
+	free(_keyframeState);
+	_keyframeState = 0;
+	free(_encodeBuf);
+	_encodeBuf = 0;
+}
+
+void RewindBuffer::clear() {
+	while (_count != 0) {
+		removeFirstFrames();
+	}
+	_head = 0;
+	_framesSinceKeyframe = 0;
+}
+
+void RewindBuffer::push(const uint8_t *state) {
+	const bool keyframe = (_count == 0 || _framesSinceKeyframe >= kKeyframeInterval);
+	const uint32_t size = encodeState(state, keyframe ? 0 : _keyframeState, _stateSize, _encodeBuf);
+	if (_count == kMaxFrames) {
+		removeFirstFrames();
+	}
+	Frame *f = getFrame(_count);
+	f->data = (uint8_t *)malloc(size);
+	if (!f->data) {
+		warning("Unable to allocate %d bytes for rewind frame", size);
+		return;
+	}
+	memcpy(f->data, _encodeBuf, size);
+	f->size = size;
+	f->keyframe = keyframe;
+	++_count;
+	_dataSize += size;
+	if (keyframe) {
+		memcpy(_keyframeState, state, _stateSize);
+		++_keyframesCount;
+		_framesSinceKeyframe = 1;
+	} else {
+		++_framesSinceKeyframe;
+	}
+	while (_dataSize > kMaxDataSize && _keyframesCount > 1) {
+		removeFirstFrames();
+	}
+}
+
+bool RewindBuffer::pop(uint8_t *state) {
+	if (_count < 2) {
+		return false;
+	}
+	Frame *f = getFrame(_count - 1);
+	const bool keyframe = f->keyframe;
+	free(f->data);
+	f->data = 0;
+	_dataSize -= f->size;
+	--_count;
+	if (keyframe) {
+		--_keyframesCount;
+	}
+	int num = _count - 1;
+	while (!getFrame(num)->keyframe) {
+		--num;
+	}
+	_framesSinceKeyframe = _count - num;
+	if (keyframe) {
+		decodeFrame(getFrame(num), _keyframeState);
+	}
+	decodeFrame(getFrame(_count - 1), state);
+	return true;
+}
+
+void RewindBuffer::removeFirstFrames() {
+	// deltas cannot be decoded without their keyframe, drop the whole group
+	do {
+		Frame *f = getFrame(0);
+		if (f->keyframe) {
+			--_keyframesCount;
+		}
+		free(f->data);
+		f->data = 0;
+		_dataSize -= f->size;
+		_head = (_head + 1) % kMaxFrames;
+		--_count;
+	} while (_count != 0 && !getFrame(0)->keyframe);
+}
+
+void RewindBuffer::decodeFrame(const Frame *f, uint8_t *state) const {
+	if (f->keyframe) {
+		memset(state, 0, _stateSize);
+	} else {
+		memcpy(state, _keyframeState, _stateSize);
+	}
+	const uint8_t *p = f->data;
+	const uint8_t *end = p + f->size;
+	uint32_t pos = 0;
+	while (p < end) {
+		pos += READ_LE_UINT16(p);
+		uint32_t count = READ_LE_UINT16(p + 2);
+		p += 4;
+		while (count--) {
+			state[pos++] ^= *p++;
+		}
+	}
+}
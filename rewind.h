@@ -0,0 +1,51 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef REWIND_H__
+#define REWIND_H__
+
+#include "intern.h"
+
+// ring buffer of per-frame game states : every kKeyframeInterval frames a full
+// state is stored, the frames in between are stored as a XOR against that keyframe.
+// Both are run-length encoded as [zero bytes count][literal bytes count][literal bytes].
+
+struct RewindBuffer {
+	enum {
+		kKeyframeInterval = 90,
+		kMaxFrames = 30 * 60, // one minute of gameplay
+		kMaxDataSize = 1024 * 1024
+	};
+
+	struct Frame {
+		uint8_t *data;
+		uint32_t size;
+		bool keyframe;
+	};
+
+	uint32_t _stateSize;
+	Frame *_frames;
+	int _head, _count;
+	int _keyframesCount;
+	int _framesSinceKeyframe;
+	uint32_t _dataSize;
+	uint8_t *_keyframeState;
+	uint8_t *_encodeBuf;
+
+	RewindBuffer();
+
+	bool init(uint32_t stateSize);
+	void fini();
+	void clear();
+	void push(const uint8_t *state);
+	bool pop(uint8_t *state);
+
+	Frame *getFrame(int num) { return &_frames[(_head + num) % kMaxFrames]; }
+	void removeFirstFrames();
+	void decodeFrame(const Frame *f, uint8_t *state) const;
+};
+
+#endif // REWIND_H__
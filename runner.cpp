@@ -0,0 +1,372 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include <SDL.h>
+#include <getopt.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include "config.h"
+#include "fs.h"
+#include "game.h"
+#include "systemstub.h"
+#include "util.h"
+
+static const char *USAGE =
+	"REminiscence - Flashback Interpreter, headless replays runner\n"
+	"Usage: %s [OPTIONS]... LIST\n"
+	"  --datapath=PATH   Path to data files (default 'DATA')\n"
+	"  --savepath=PATH   Path to the jobs save files directories (default '.')\n"
+	"  --threads=NUM     Number of worker threads (default is the number of CPUs)\n"
+	"  --startup=NUM     Time NUM game startups instead of running LIST\n"
+	"  --serial-startup  Run the startup tasks one after another\n"
+	"\n"
+	"Each line of LIST is a file recorded with --record, or 'demo:NUM' for the\n"
+	"game demos, optionally followed by the expected final state hash.\n"
+;
+
+static const int kMaxJobs = 4096;
+
+struct Job {
+	char name[256];
+	int demoNum;
+	bool hasExpectedHash;
+	uint64_t expectedHash;
+	uint32_t frames;
+	uint64_t duration;
+	uint64_t hash;
+	bool done;
+};
+
+struct JobQueue {
+	SDL_mutex *mutex;
+	int *jobs;
+	int head, tail;
+};
+
+struct Runner;
+
+struct Worker {
+	Runner *runner;
+	int queue;
+};
+
+struct Runner {
+	const char *_dataPath;
+	const char *_savePath;
+	ResourceType _version;
+	Language _language;
+	Options _options;
+	Job *_jobs;
+	int _jobsCount;
+	JobQueue *_queues;
+	int _threadsCount;
+
+	void benchmarkStartup(int count, bool parallel);
+	bool loadJobs(const char *listPath);
+	void runJobs();
+	bool popJob(int queue, int *num);
+	bool stealJob(int queue, int *num);
+	void runJob(int num);
+	bool printResults(uint64_t duration);
+};
+
+void Runner::benchmarkStartup(int count, bool parallel) {
+	// the first startup of the process is the cold one, it is the only one reading the data
+	// files from the disk if the system file cache was dropped before
+	uint64_t coldTime = 0, warmTime = 0, warmMin = 0, warmMax = 0;
+	for (int i = 0; i < count; ++i) {
+		const uint64_t t = getTimeNs();
+		FileSystem fs(_dataPath);
+		const int version = detectVersion(&fs);
+		if (version == -1) {
+			error("Unable to find data files, check that all required files are present");
+			return;
+		}
+		const Language language = detectLanguage(&fs);
+		SystemStub *stub = SystemStub_Null_create();
+		stub->init(g_caption, Video::GAMESCREEN_W, Video::GAMESCREEN_H, false, 0);
+		Game *g = new Game(stub, &fs, _savePath, 0, -1, (ResourceType)version, language, _options);
+		g->_startupParallel = parallel;
+		g->runStartupTasks();
+		const uint64_t duration = getTimeNs() - t;
+		g->_res.free_TEXT();
+		g->_mix.free();
+		delete g;
+		stub->destroy();
+		delete stub;
+		if (i == 0) {
+			coldTime = duration;
+		} else {
+			warmTime += duration;
+			if (i == 1 || duration < warmMin) {
+				warmMin = duration;
+			}
+			if (i == 1 || duration > warmMax) {
+				warmMax = duration;
+			}
+		}
+	}
+	printf("%s startup: cold %.3f ms", parallel ? "Parallel" : "Serial", coldTime / 1000000.);
+	if (count > 1) {
+		printf(", warm %.3f ms (min %.3f ms, max %.3f ms, %d runs)", warmTime / 1000000. / (count - 1), warmMin / 1000000., warmMax / 1000000., count - 1);
+	}
+	printf("\n");
+}
+
+bool Runner::loadJobs(const char *listPath) {
+	FILE *fp = fopen(listPath, "r");
+	if (!fp) {
+		warning("Unable to open jobs list '%s'", listPath);
+		return false;
+	}
+	_jobs = (Job *)calloc(kMaxJobs, sizeof(Job));
+	if (!_jobs) {
+		warning("Unable to allocate %d jobs", kMaxJobs);
+		fclose(fp);
+		return false;
+	}
+	_jobsCount = 0;
+	char buf[512];
+	while (fgets(buf, sizeof(buf), fp) && _jobsCount < kMaxJobs) {
+		if (buf[0] == '#') {
+			continue;
+		}
+		Job *job = &_jobs[_jobsCount];
+		unsigned long long hash;
+		const int count = sscanf(buf, "%255s %llx", job->name, &hash);
+		if (count < 1) {
+			continue;
+		}
+		job->demoNum = -1;
+		if (strncmp(job->name, "demo:", 5) == 0) {
+			job->demoNum = atoi(job->name + 5);
+		}
+		job->hasExpectedHash = (count == 2);
+		job->expectedHash = job->hasExpectedHash ? hash : 0;
+		++_jobsCount;
+	}
+	fclose(fp);
+	return _jobsCount != 0;
+}
+
+bool Runner::popJob(int queue, int *num) {
+	JobQueue *q = &_queues[queue];
+	bool ret = false;
+	SDL_LockMutex(q->mutex);
+	if (q->head < q->tail) {
+		*num = q->jobs[--q->tail];
+		ret = true;
+	}
+	SDL_UnlockMutex(q->mutex);
+	return ret;
+}
+
+bool Runner::stealJob(int queue, int *num) {
+	// take the oldest job of the other queues, the owners work from the other end
+	for (int i = 1; i < _threadsCount; ++i) {
+		JobQueue *q = &_queues[(queue + i) % _threadsCount];
+		bool ret = false;
+		SDL_LockMutex(q->mutex);
+		if (q->head < q->tail) {
+			*num = q->jobs[q->head++];
+			ret = true;
+		}
+		SDL_UnlockMutex(q->mutex);
+		if (ret) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void Runner::runJob(int num) {
+	Job *job = &_jobs[num];
+	char savePath[MAXPATHLEN];
+	snprintf(savePath, sizeof(savePath), "%s/job-%04d", _savePath, num);
+	mkdir(savePath, 0755);
+	FileSystem fs(_dataPath);
+	SystemStub *stub = SystemStub_Null_create();
+	stub->init(g_caption, Video::GAMESCREEN_W, Video::GAMESCREEN_H, false, 0);
+	Game *g = new Game(stub, &fs, savePath, 0, job->demoNum, _version, _language, _options);
+	if (job->demoNum == -1) {
+		g->_replayPath = job->name;
+	}
+	const uint64_t t = getTimeNs();
+	g->run();
+	job->duration = getTimeNs() - t;
+	job->frames = g->_framesCount;
+	uint8_t *buf = (uint8_t *)malloc(Game::kStateHashBufferSize);
+	if (buf) {
+		job->hash = g->hashGameState(buf);
+		free(buf);
+	}
+	delete g;
+	stub->destroy();
+	delete stub;
+	job->done = true;
+}
+
+static int workerThread(void *param) {
+	Worker *w = (Worker *)param;
+	int num;
+	while (w->runner->popJob(w->queue, &num) || w->runner->stealJob(w->queue, &num)) {
+		w->runner->runJob(num);
+	}
+	return 0;
+}
+
+void Runner::runJobs() {
+	_queues = (JobQueue *)calloc(_threadsCount, sizeof(JobQueue));
+	SDL_Thread **threads = (SDL_Thread **)calloc(_threadsCount, sizeof(SDL_Thread *));
+	Worker *workers = (Worker *)calloc(_threadsCount, sizeof(Worker));
+	if (!_queues || !threads || !workers) {
+		error("Unable to allocate %d worker threads", _threadsCount);
+		return;
+	}
+	// jobs are dealt round robin, a worker with an empty queue steals from the others
+	for (int i = 0; i < _threadsCount; ++i) {
+		JobQueue *q = &_queues[i];
+		q->mutex = SDL_CreateMutex();
+		q->jobs = (int *)malloc(_jobsCount * sizeof(int));
+		if (!q->mutex || !q->jobs) {
+			error("Unable to allocate job queue %d", i);
+			return;
+		}
+		q->head = q->tail = 0;
+	}
+	for (int i = 0; i < _jobsCount; ++i) {
+		JobQueue *q = &_queues[i % _threadsCount];
+		q->jobs[q->tail++] = _jobsCount - 1 - i;
+	}
+	for (int i = 0; i < _threadsCount; ++i) {
+		workers[i].runner = this;
+		workers[i].queue = i;
+		threads[i] = SDL_CreateThread(workerThread, "Runner", &workers[i]);
+		if (!threads[i]) {
+			warning("Unable to create worker thread %d", i);
+		}
+	}
+	for (int i = 0; i < _threadsCount; ++i) {
+		if (threads[i]) {
+			SDL_WaitThread(threads[i], 0);
+		}
+	}
+	// jobs left by the threads which could not be created
+	int num;
+	for (int i = 0; i < _threadsCount; ++i) {
+		while (popJob(i, &num)) {
+			runJob(num);
+		}
+	}
+	for (int i = 0; i < _threadsCount; ++i) {
+		SDL_DestroyMutex(_queues[i].mutex);
+		free(_queues[i].jobs);
+	}
+	free(_queues);
+	_queues = 0;
+	free(threads);
+	free(workers);
+}
+
+bool Runner::printResults(uint64_t duration) {
+	int passed = 0, failed = 0;
+	uint64_t totalFrames = 0;
+	for (int i = 0; i < _jobsCount; ++i) {
+		const Job *job = &_jobs[i];
+		const char *status = "-";
+		if (job->hasExpectedHash) {
+			if (job->done && job->hash == job->expectedHash) {
+				status = "PASS";
+				++passed;
+			} else {
+				status = "FAIL";
+				++failed;
+			}
+		}
+		totalFrames += job->frames;
+		printf("%-40s %8u frames %10.1f fps %016llx %s\n", job->name, job->frames,
+			job->duration ? job->frames * 1000000000. / job->duration : 0., (unsigned long long)job->hash, status);
+	}
+	printf("%d jobs on %d threads in %.3f s (%.1f fps), %d passed, %d failed\n", _jobsCount, _threadsCount, duration / 1000000000.,
+		duration ? totalFrames * 1000000000. / duration : 0., passed, failed);
+	return failed == 0;
+}
+
+int main(int argc, char *argv[]) {
+	Runner runner;
+	memset(&runner, 0, sizeof(runner));
+	runner._dataPath = "DATA";
+	runner._savePath = ".";
+	runner._threadsCount = 0;
+	int startupCount = 0;
+	bool parallelStartup = true;
+	while (1) {
+		static struct option options[] = {
+			{ "datapath", required_argument, 0, 1 },
+			{ "savepath", required_argument, 0, 2 },
+			{ "threads",  required_argument, 0, 3 },
+			{ "startup",  required_argument, 0, 4 },
+			{ "serial-startup", no_argument, 0, 5 },
+			{ 0, 0, 0, 0 }
+		};
+		int index;
+		const int c = getopt_long(argc, argv, "", options, &index);
+		if (c == -1) {
+			break;
+		}
+		switch (c) {
+		case 1:
+			runner._dataPath = strdup(optarg);
+			break;
+		case 2:
+			runner._savePath = strdup(optarg);
+			break;
+		case 3:
+			runner._threadsCount = atoi(optarg);
+			break;
+		case 4:
+			startupCount = atoi(optarg);
+			break;
+		case 5:
+			parallelStartup = false;
+			break;
+		default:
+			printf(USAGE, argv[0]);
+			return 0;
+		}
+	}
+	if (optind != argc - 1 && startupCount <= 0) {
+		printf(USAGE, argv[0]);
+		return 0;
+	}
+	if (runner._threadsCount <= 0) {
+		runner._threadsCount = SDL_GetCPUCount();
+	}
+	initOptions(&runner._options);
+	runner._options.bypass_protection = true;
+	runner._options.enable_rewind = false;
+	g_debugMask = 0;
+	if (startupCount > 0) {
+		runner.benchmarkStartup(startupCount, parallelStartup);
+		return 0;
+	}
+	FileSystem fs(runner._dataPath);
+	const int version = detectVersion(&fs);
+	if (version == -1) {
+		error("Unable to find data files, check that all required files are present");
+		return -1;
+	}
+	runner._version = (ResourceType)version;
+	runner._language = detectLanguage(&fs);
+	if (!runner.loadJobs(argv[optind])) {
+		return -1;
+	}
+	const uint64_t t = getTimeNs();
+	runner.runJobs();
+	const bool success = runner.printResults(getTimeNs() - t);
+	free(runner._jobs);
+	return success ? 0 : 1;
+}
@@ -89,39 +89,57 @@ static void scale3x(uint32_t *dst, int dstPitch, const uint32_t *src, int srcPit
 	}
 }
 
-static void scale4x(uint32_t *dst, int dstPitch, const uint32_t *src, int srcPitch, int w, int h) {
-	static struct {
-		uint32_t *ptr;
-		int w, h, pitch;
-		int size;
-	} buf;
-	const int size = (w * 2) * (h * 2) * sizeof(uint32_t);
-	if (buf.size < size) {
-		free(buf.ptr);
-		buf.size = size;
-		buf.w = w * 2;
-		buf.h = h * 2;
-		buf.pitch = buf.w;
-		buf.ptr = (uint32_t *)malloc(buf.size);
-		if (!buf.ptr) {
+static void scale4x(uint32_t *dst, int dstPitch, const uint32_t *src, int srcPitch, int w, int h, ScalerBuffer *buf) {
+	const int bufW = w * 2;
+	const int bufH = h * 2;
+	if (buf->size < bufW * bufH) {
+		free(buf->ptr);
+		buf->size = bufW * bufH;
+		buf->ptr = (uint32_t *)malloc(buf->size * sizeof(uint32_t));
+		if (!buf->ptr) {
+			buf->size = 0;
 			error("Unable to allocate scale4x intermediate buffer");
+			return;
 		}
 	}
-	scale2x(buf.ptr, buf.pitch, src, srcPitch, w, h);
-	scale2x(dst, dstPitch, buf.ptr, buf.pitch, buf.w, buf.h);
+	scale2x(buf->ptr, bufW, src, srcPitch, w, h);
+	scale2x(dst, dstPitch, buf->ptr, bufW, bufW, bufH);
 }
 
-static void scaleNx(int factor, uint32_t *dst, int dstPitch, const uint32_t *src, int srcPitch, int w, int h) {
+static void scaleNxBuffer(int factor, uint32_t *dst, int dstPitch, const uint32_t *src, int srcPitch, int w, int h, ScalerBuffer *buf) {
 	switch (factor) {
 	case 2:
 		return scale2x(dst, dstPitch, src, srcPitch, w, h);
 	case 3:
 		return scale3x(dst, dstPitch, src, srcPitch, w, h);
 	case 4:
-		return scale4x(dst, dstPitch, src, srcPitch, w, h);
+		return scale4x(dst, dstPitch, src, srcPitch, w, h, buf);
+	}
+}
+
+static void scaleNx(int factor, uint32_t *dst, int dstPitch, const uint32_t *src, int srcPitch, int w, int h) {
+	// called without a buffer, the intermediate one is allocated for this frame
+	ScalerBuffer buf;
+	buf.ptr = 0;
+	buf.size = 0;
+	scaleNxBuffer(factor, dst, dstPitch, src, srcPitch, w, h, &buf);
+	freeScalerBuffer(&buf);
+}
+
+void scaleWithBuffer(const Scaler *scaler, ScalerBuffer *buf, int factor, uint32_t *dst, int dstPitch, const uint32_t *src, int srcPitch, int w, int h) {
+	if (scaler == &_internalScaler) {
+		scaleNxBuffer(factor, dst, dstPitch, src, srcPitch, w, h, buf);
+	} else {
+		scaler->scale(factor, dst, dstPitch, src, srcPitch, w, h);
 	}
 }
 
+void freeScalerBuffer(ScalerBuffer *buf) {
+	free(buf->ptr);
+	buf->ptr = 0;
+	buf->size = 0;
+}
+
 const Scaler _internalScaler = {
 	SCALER_TAG,
 	"scaleNx",
@@ -129,16 +147,16 @@ const Scaler _internalScaler = {
 	scaleNx,
 };
 
-static DynLib *dynLib;
-
 static const char *kSoSym = "getScaler";
 
-const Scaler *findScaler(const char *name) {
-	dynLib = new DynLib(name);
-	void *symbol = dynLib->getSymbol(kSoSym);
+const Scaler *findScaler(const char *name, DynLib **lib) {
+	*lib = new DynLib(name);
+	void *symbol = (*lib)->getSymbol(kSoSym);
 	if (symbol) {
 		typedef const Scaler *(*GetScalerProc)();
 		return ((GetScalerProc)symbol)();
 	}
+	delete *lib;
+	*lib = 0;
 	return 0;
 }
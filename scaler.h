@@ -29,6 +29,18 @@ struct Scaler {
 
 extern const Scaler _internalScaler;
 
-const Scaler *findScaler(const char *name);
+// intermediate buffer of the internal scaler, kept by each caller (presentation, screenshots) so it
+// is allocated once and not shared between threads
+struct ScalerBuffer {
+	uint32_t *ptr;
+	int size;
+};
+
+void scaleWithBuffer(const Scaler *scaler, ScalerBuffer *buf, int factor, uint32_t *dst, int dstPitch, const uint32_t *src, int srcPitch, int w, int h);
+void freeScalerBuffer(ScalerBuffer *buf);
+
+struct DynLib;
+
+const Scaler *findScaler(const char *name, DynLib **lib); // the library must be kept loaded while the scaler is in use
 
 #endif // SCALER_H__
@@ -0,0 +1,84 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include <math.h>
+#include "scheduler.h"
+#include "systemstub.h"
+#include "util.h"
+
+void FrameScheduler::init(SystemStub *stub) {
+	_stub = stub;
+	_period = 0;
+	memset(_stats, 0, sizeof(_stats));
+	_statsCount = 0;
+	reset();
+}
+
+void FrameScheduler::reset() {
+	_timestamp = getTimeNs();
+	_accumulator = 0;
+	_started = false;
+}
+
+void FrameScheduler::wait(uint64_t period) {
+	if (period != _period) {
+		// another loop, the first frame lasts one period from now
+		_period = period;
+		reset();
+	}
+	uint64_t now = getTimeNs();
+	const uint64_t duration = now - _timestamp;
+	_accumulator += duration;
+	const bool late = _accumulator >= period;
+	if (!late) {
+		_stub->sleepUntil(now + period - _accumulator);
+		const uint64_t t = getTimeNs();
+		_accumulator += t - now;
+		now = t;
+	}
+	if (_started) {
+		updateStats(now - _timestamp, late);
+	}
+	_started = true;
+	_accumulator = (_accumulator > period) ? MIN(_accumulator - period, (uint64_t)kMaxLag * period) : 0;
+	_timestamp = now;
+}
+
+void FrameScheduler::updateStats(uint64_t duration, bool late) {
+	Stats *s = 0;
+	for (int i = 0; i < _statsCount; ++i) {
+		if (_stats[i].period == _period) {
+			s = &_stats[i];
+			break;
+		}
+	}
+	if (!s) {
+		if (_statsCount == kStatsCount) {
+			return;
+		}
+		s = &_stats[_statsCount++];
+		s->period = _period;
+	}
+	const uint64_t jitter = (duration > _period) ? duration - _period : _period - duration;
+	++s->frames;
+	if (late) {
+		++s->lateFrames;
+	}
+	s->jitterSum += jitter;
+	s->jitterSqSum += (double)jitter * jitter;
+	s->jitterMax = MAX(s->jitterMax, jitter);
+}
+
+void FrameScheduler::printStats() const {
+	printf("Frames pacing:\n");
+	for (int i = 0; i < _statsCount; ++i) {
+		const Stats *s = &_stats[i];
+		const double avg = (double)s->jitterSum / s->frames;
+		const double stddev = sqrt(MAX(s->jitterSqSum / s->frames - avg * avg, 0.));
+		printf("  %8.3f ms period %8u frames, jitter avg %.3f ms stddev %.3f ms max %.3f ms, %u late\n",
+			s->period / 1000000., s->frames, avg / 1000000., stddev / 1000000., s->jitterMax / 1000000., s->lateFrames);
+	}
+}
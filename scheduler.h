@@ -0,0 +1,47 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef SCHEDULER_H__
+#define SCHEDULER_H__
+
+#include "intern.h"
+
+struct SystemStub;
+
+// paces the game, cutscenes, videos and menus loops. The frames are started at fixed steps of
+// the period, a late frame is caught up by the next ones, up to kMaxLag periods.
+
+struct FrameScheduler {
+	enum {
+		kMaxLag = 2,
+		kStatsCount = 8
+	};
+
+	struct Stats {
+		uint64_t period;
+		uint32_t frames;
+		uint32_t lateFrames;
+		uint64_t jitterSum, jitterMax; // ns, difference between the frame duration and the period
+		double jitterSqSum;
+	};
+
+	SystemStub *_stub;
+	uint64_t _period; // ns
+	uint64_t _timestamp; // start of the current frame
+	uint64_t _accumulator;
+	bool _started;
+	Stats _stats[kStatsCount]; // by period
+	int _statsCount;
+
+	void init(SystemStub *stub);
+	void reset();
+	void wait(uint64_t period);
+	void waitMs(int ms) { wait(ms * 1000000ULL); }
+	void updateStats(uint64_t duration, bool late);
+	void printStats() const;
+};
+
+#endif // SCHEDULER_H__
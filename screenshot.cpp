@@ -1,6 +1,12 @@
 
+#include <SDL.h>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#include "scaler.h"
 #include "screenshot.h"
 #include "file.h"
+#include "util.h"
 
 static void TO_LE16(uint8_t *dst, uint16_t value) {
 	for (int i = 0; i < 2; ++i) {
@@ -9,6 +15,13 @@ static void TO_LE16(uint8_t *dst, uint16_t value) {
 	}
 }
 
+static void TO_BE32(uint8_t *dst, uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		dst[3 - i] = value & 255;
+		value >>= 8;
+	}
+}
+
 #define kTgaImageTypeUncompressedTrueColor 2
 #define kTgaImageTypeRunLengthEncodedTrueColor 10
 #define kTgaDirectionTop (1 << 5)
@@ -68,3 +81,224 @@ void saveTGA(const char *filename, const uint8_t *rgba, int w, int h) {
 		}
 	}
 }
+
+#ifdef USE_ZLIB
+
+static const uint8_t kPngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+static void writePngChunk(File *f, const char *type, const uint8_t *data, uint32_t size) {
+	uint8_t buffer[4];
+	TO_BE32(buffer, size);
+	f->write(buffer, 4);
+	f->write(type, 4);
+	uLong crc = crc32(0, (const Bytef *)type, 4);
+	if (size != 0) {
+		f->write(data, size);
+		crc = crc32(crc, data, size);
+	}
+	TO_BE32(buffer, crc);
+	f->write(buffer, 4);
+}
+
+bool savePNG(const char *filename, const uint32_t *rgb, int w, int h) {
+	// 24 bits truecolor, each scanline is stored with the 'sub' filter
+	const int pitch = 1 + w * 3;
+	const uLong rawSize = pitch * h;
+	uint8_t *raw = (uint8_t *)malloc(rawSize);
+	uLongf dataSize = compressBound(rawSize);
+	uint8_t *data = (uint8_t *)malloc(dataSize);
+	if (!raw || !data) {
+		warning("Unable to allocate PNG buffers for '%s'", filename);
+		free(raw);
+		free(data);
+		return false;
+	}
+	uint8_t *p = raw;
+	for (int y = 0; y < h; ++y) {
+		*p++ = 1;
+		int prevR = 0, prevG = 0, prevB = 0;
+		for (int x = 0; x < w; ++x) {
+			const uint32_t color = *rgb++;
+			const int r = (color >> 16) & 255;
+			const int g = (color >>  8) & 255;
+			const int b =  color        & 255;
+			*p++ = r - prevR;
+			*p++ = g - prevG;
+			*p++ = b - prevB;
+			prevR = r;
+			prevG = g;
+			prevB = b;
+		}
+	}
+	const int ret = compress2(data, &dataSize, raw, rawSize, Z_DEFAULT_COMPRESSION);
+	free(raw);
+	if (ret != Z_OK) {
+		warning("Unable to compress PNG data for '%s', ret %d", filename, ret);
+		free(data);
+		return false;
+	}
+	bool success = false;
+	File f;
+	if (f.open(filename, "wb", ".")) {
+		f.write(kPngSignature, sizeof(kPngSignature));
+		uint8_t hdr[13];
+		TO_BE32(hdr, w);
+		TO_BE32(hdr + 4, h);
+		hdr[8]  = 8; // bit depth
+		hdr[9]  = 2; // color type, truecolor
+		hdr[10] = 0; // compression method
+		hdr[11] = 0; // filter method
+		hdr[12] = 0; // interlace method
+		writePngChunk(&f, "IHDR", hdr, sizeof(hdr));
+		writePngChunk(&f, "IDAT", data, dataSize);
+		writePngChunk(&f, "IEND", 0, 0);
+		success = !f.ioErr();
+	}
+	free(data);
+	return success;
+}
+
+static const char *kScreenshotExtension = "png";
+
+#else
+
+static const char *kScreenshotExtension = "tga";
+
+#endif
+
+static int writerThread(void *param) {
+	((ScreenshotWriter *)param)->processRequests();
+	return 0;
+}
+
+ScreenshotWriter::ScreenshotWriter()
+	: _thread(0), _mutex(0), _cond(0), _quit(false), _next(0) {
+	memset(_requests, 0, sizeof(_requests));
+	memset(&_scalerBuffer, 0, sizeof(_scalerBuffer));
+}
+
+void ScreenshotWriter::init() {
+	_quit = false;
+	_mutex = SDL_CreateMutex();
+	_cond = SDL_CreateCond();
+	if (_mutex && _cond) {
+		_thread = SDL_CreateThread(writerThread, "ScreenshotWriter", this);
+	}
+	if (!_thread) {
+		warning("Unable to create screenshot writer thread, writing synchronously");
+	}
+}
+
+void ScreenshotWriter::fini() {
+	if (_thread) {
+		SDL_LockMutex(_mutex);
+		_quit = true;
+		SDL_CondBroadcast(_cond);
+		SDL_UnlockMutex(_mutex);
+		SDL_WaitThread(_thread, 0);
+		_thread = 0;
+	}
+	for (int i = 0; i < kBuffersCount; ++i) {
+		free(_requests[i].buffer);
+		_requests[i].buffer = 0;
+		_requests[i].bufferSize = 0;
+	}
+	freeScalerBuffer(&_scalerBuffer);
+	if (_cond) {
+		SDL_DestroyCond(_cond);
+		_cond = 0;
+	}
+	if (_mutex) {
+		SDL_DestroyMutex(_mutex);
+		_mutex = 0;
+	}
+}
+
+void ScreenshotWriter::queue(const char *prefix, int num, const uint32_t *rgb, int w, int h, const Scaler *scaler, int scaleFactor) {
+	if (_thread) {
+		SDL_LockMutex(_mutex);
+		// both buffers are being encoded, wait for the oldest one
+		while (_requests[_next].pending) {
+			SDL_CondWait(_cond, _mutex);
+		}
+		SDL_UnlockMutex(_mutex);
+	}
+	Request *r = &_requests[_next];
+	const int size = w * h;
+	if (r->bufferSize < size) {
+		free(r->buffer);
+		r->buffer = (uint32_t *)malloc(size * sizeof(uint32_t));
+		if (!r->buffer) {
+			warning("Unable to allocate screenshot buffer %dx%d", w, h);
+			r->bufferSize = 0;
+			return;
+		}
+		r->bufferSize = size;
+	}
+	memcpy(r->buffer, rgb, size * sizeof(uint32_t));
+	snprintf(r->name, sizeof(r->name), "%s-%03d.%s", prefix, num, kScreenshotExtension);
+	r->w = w;
+	r->h = h;
+	r->scaler = scaler;
+	r->scaleFactor = scaleFactor;
+	_next = (_next + 1) % kBuffersCount;
+	if (!_thread) {
+		writeRequest(r);
+		return;
+	}
+	SDL_LockMutex(_mutex);
+	r->pending = true;
+	SDL_CondBroadcast(_cond);
+	SDL_UnlockMutex(_mutex);
+}
+
+void ScreenshotWriter::writeRequest(Request *r) {
+	const uint32_t *rgb = r->buffer;
+	int w = r->w;
+	int h = r->h;
+	uint32_t *scaled = 0;
+	if (r->scaler && r->scaleFactor > 1) {
+		scaled = (uint32_t *)malloc(w * r->scaleFactor * h * r->scaleFactor * sizeof(uint32_t));
+		if (scaled) {
+			scaleWithBuffer(r->scaler, &_scalerBuffer, r->scaleFactor, scaled, w * r->scaleFactor, r->buffer, w, w, h);
+			rgb = scaled;
+			w *= r->scaleFactor;
+			h *= r->scaleFactor;
+		} else {
+			warning("Unable to allocate scaled screenshot buffer, writing '%s' unscaled", r->name);
+		}
+	}
+#ifdef USE_ZLIB
+	const bool success = savePNG(r->name, rgb, w, h);
+#else
+	saveTGA(r->name, (const uint8_t *)rgb, w, h);
+	const bool success = true;
+#endif
+	free(scaled);
+	if (success) {
+		debug(DBG_INFO, "Written '%s'", r->name);
+	} else {
+		warning("Unable to write screenshot '%s'", r->name);
+	}
+}
+
+void ScreenshotWriter::processRequests() {
+	SDL_LockMutex(_mutex);
+	int current = 0;
+	while (1) {
+		while (!_requests[current].pending && !_quit) {
+			SDL_CondWait(_cond, _mutex);
+		}
+		Request *r = &_requests[current];
+		if (!r->pending) {
+			break;
+		}
+		SDL_UnlockMutex(_mutex);
+		writeRequest(r);
+		SDL_LockMutex(_mutex);
+		r->pending = false;
+		current = (current + 1) % kBuffersCount;
+		SDL_CondBroadcast(_cond);
+	}
+	SDL_UnlockMutex(_mutex);
+}
@@ -3,7 +3,50 @@
 #define SCREENSHOT_H__
 
 #include <stdint.h>
+#include "scaler.h"
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
 
 void saveTGA(const char *filename, const uint8_t *rgb, int w, int h);
+#ifdef USE_ZLIB
+bool savePNG(const char *filename, const uint32_t *rgb, int w, int h);
+#endif
+
+// copies the frames to pooled buffers, scales and encodes them from a background thread
+
+struct ScreenshotWriter {
+	enum {
+		kBuffersCount = 2
+	};
+
+	struct Request {
+		char name[32];
+		uint32_t *buffer;
+		int bufferSize;
+		int w, h;
+		const Scaler *scaler;
+		int scaleFactor;
+		bool pending;
+	};
+
+	SDL_Thread *_thread;
+	SDL_mutex *_mutex;
+	SDL_cond *_cond;
+	bool _quit;
+	Request _requests[kBuffersCount];
+	int _next;
+	ScalerBuffer _scalerBuffer; // writer thread
+
+	ScreenshotWriter();
+
+	void init();
+	void fini();
+	void queue(const char *prefix, int num, const uint32_t *rgb, int w, int h, const Scaler *scaler = 0, int scaleFactor = 1);
+
+	void writeRequest(Request *r);
+	void processRequests();
+};
 
 #endif
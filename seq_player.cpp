@@ -233,8 +233,8 @@ void SeqPlayer::play(File *f) {
 		_mix->setPremixHook(mixCallback, this);
 		memset(_buf, 0, 256 * 224);
 		bool clearScreen = true;
+		_stub->_scheduler.reset();
 		while (true) {
-			const uint32_t nextFrameTimeStamp = _stub->getTimeStamp() + 1000 / 25;
 			_stub->processEvents();
 			if (_stub->_pi.quit || _stub->_pi.backspace) {
 				_stub->_pi.backspace = false;
@@ -310,10 +310,7 @@ void SeqPlayer::play(File *f) {
 				}
 				_stub->updateScreen(0);
 			}
-			const int diff = nextFrameTimeStamp - _stub->getTimeStamp();
-			if (diff > 0) {
-				_stub->sleep(diff);
-			}
+			_stub->_scheduler.wait(1000000000 / kFrameRate);
 		}
 		for (int i = 0; i < 256; ++i) {
 			_stub->setPaletteEntry(i, &pal[i]);
@@ -49,6 +49,7 @@ struct SeqPlayer {
 	enum {
 		kVideoWidth = 256,
 		kVideoHeight = 128,
+		kFrameRate = 25,
 		kSoundPreloadSize = 4
 	};
 
@@ -0,0 +1,419 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include "game.h"
+#include "util.h"
+
+// pointers are stored as (index + 1) in the snapshot, 0 being the null pointer
+
+template<typename T>
+static T *ptrToIndex(T *p, T *base) {
+	return p ? (T *)(uintptr_t)(p - base + 1) : 0;
+}
+
+template<typename T>
+static T *indexToPtr(T *p, T *base) {
+	return p ? base + ((uintptr_t)p - 1) : 0;
+}
+
+void Game::saveSnapshot(GameSnapshot *s) {
+	s->currentLevel = _currentLevel;
+	s->skillLevel = _skillLevel;
+	s->score = _score;
+	s->currentRoom = _currentRoom;
+	s->currentIcon = _currentIcon;
+	s->loadMap = _loadMap;
+	s->printLevelCodeCounter = _printLevelCodeCounter;
+	s->randSeed = _randSeed;
+	s->currentInventoryIconNum = _currentInventoryIconNum;
+	s->blinkingConradCounter = _blinkingConradCounter;
+	s->textToDisplay = _textToDisplay;
+	s->eraseBackground = _eraseBackground;
+	s->deathCutsceneCounter = _deathCutsceneCounter;
+	s->saveStateCompleted = _saveStateCompleted;
+	s->validSaveState = _validSaveState;
+	s->cutId = _cut._id;
+	s->deathCutsceneId = _cut._deathCutsceneId;
+	memcpy(s->animBuffersPos, _animBuffers._curPos, sizeof(s->animBuffersPos));
+
+	s->pgePlayAnimSound = _pge_playAnimSound;
+	s->pgeCurrentPiegeRoom = _pge_currentPiegeRoom;
+	s->pgeCurrentPiegeFacingDir = _pge_currentPiegeFacingDir;
+	s->pgeProcessOBJ = _pge_processOBJ;
+	s->pgeInpKeysMask = _pge_inpKeysMask;
+	s->pgeOpTempVar1 = _pge_opTempVar1;
+	s->pgeOpTempVar2 = _pge_opTempVar2;
+	s->pgeCompareVar1 = _pge_compareVar1;
+	s->pgeCompareVar2 = _pge_compareVar2;
+	memcpy(s->pgeLive, _pgeLive, sizeof(_pgeLive));
+	for (int i = 0; i < 256; ++i) {
+		LivePGE *pge = &s->pgeLive[i];
+		pge->next_PGE_in_room = ptrToIndex(pge->next_PGE_in_room, _pgeLive);
+		pge->init_PGE = ptrToIndex(pge->init_PGE, _res._pgeInit);
+	}
+	memcpy(&s->pgeHot, &_pgeHot, sizeof(_pgeHot));
+	memcpy(s->pgeActiveMask, _pge_activeMask, sizeof(_pge_activeMask));
+	for (int i = 0; i < 256; ++i) {
+		s->pgeLiveTable1[i] = ptrToIndex(_pge_liveTable1[i], _pgeLive);
+	}
+	memcpy(s->pgeGroups, _pge_groups, sizeof(_pge_groups));
+	for (int i = 0; i < 256; ++i) {
+		s->pgeGroups[i].next_entry = ptrToIndex(s->pgeGroups[i].next_entry, _pge_groups);
+		s->pgeGroupsTable[i] = ptrToIndex(_pge_groupsTable[i], _pge_groups);
+	}
+	s->pgeNextFreeGroup = ptrToIndex(_pge_nextFreeGroup, _pge_groups);
+
+	s->colCurPos = _col_curPos;
+	memcpy(s->colSlots, _col_slots, sizeof(_col_slots));
+	for (int i = 0; i < 256; ++i) {
+		CollisionSlot *slot = &s->colSlots[i];
+		slot->prev_slot = ptrToIndex(slot->prev_slot, _col_slots);
+		slot->live_pge = ptrToIndex(slot->live_pge, _pgeLive);
+		s->colSlotsTable[i] = ptrToIndex(_col_slotsTable[i], _col_slots);
+	}
+	s->colCurSlot = ptrToIndex(_col_curSlot, _col_slots);
+	memcpy(s->colSlots2, _col_slots2, sizeof(_col_slots2));
+	for (int i = 0; i < 256; ++i) {
+		CollisionSlot2 *slot2 = &s->colSlots2[i];
+		slot2->next_slot = ptrToIndex(slot2->next_slot, _col_slots2);
+		slot2->unk2 = ptrToIndex(slot2->unk2, _res._ctData);
+	}
+	s->colSlots2Cur = ptrToIndex(_col_slots2Cur, _col_slots2);
+	s->colSlots2Next = ptrToIndex(_col_slots2Next, _col_slots2);
+	memcpy(s->colActiveCollisionSlots, _col_activeCollisionSlots, sizeof(_col_activeCollisionSlots));
+	s->colCurrentLeftRoom = _col_currentLeftRoom;
+	s->colCurrentRightRoom = _col_currentRightRoom;
+	s->colCurrentPiegeGridPosX = _col_currentPiegeGridPosX;
+	s->colCurrentPiegeGridPosY = _col_currentPiegeGridPosY;
+	memcpy(s->ctData, _res._ctData, sizeof(_res._ctData));
+
+	s->inpLastKeysHit = _inp_lastKeysHit;
+	s->inpLastKeysHitLeftRight = _inp_lastKeysHitLeftRight;
+	s->inpDemPos = _inp_demPos;
+}
+
+void Game::restoreSnapshot(const GameSnapshot *s) {
+	const uint8_t prevRoom = _currentRoom;
+	const bool levelChanged = (s->currentLevel != _currentLevel);
+	if (levelChanged) {
+		_currentLevel = s->currentLevel;
+		loadLevelData();
+	}
+	_currentLevel = s->currentLevel;
+	_skillLevel = s->skillLevel;
+	_score = s->score;
+	_currentRoom = s->currentRoom;
+	if ((levelChanged || _currentRoom != prevRoom) && !(_currentRoom & 0x80)) {
+		loadLevelMap();
+		_vid.fullRefresh();
+	}
+	_currentIcon = s->currentIcon;
+	_loadMap = s->loadMap;
+	_printLevelCodeCounter = s->printLevelCodeCounter;
+	_randSeed = s->randSeed;
+	_currentInventoryIconNum = s->currentInventoryIconNum;
+	_blinkingConradCounter = s->blinkingConradCounter;
+	_textToDisplay = s->textToDisplay;
+	_eraseBackground = s->eraseBackground;
+	_deathCutsceneCounter = s->deathCutsceneCounter;
+	_saveStateCompleted = s->saveStateCompleted;
+	_validSaveState = s->validSaveState;
+	_cut._id = s->cutId;
+	_cut._deathCutsceneId = s->deathCutsceneId;
+	memcpy(_animBuffers._curPos, s->animBuffersPos, sizeof(_animBuffers._curPos));
+
+	_pge_playAnimSound = s->pgePlayAnimSound;
+	_pge_currentPiegeRoom = s->pgeCurrentPiegeRoom;
+	_pge_currentPiegeFacingDir = s->pgeCurrentPiegeFacingDir;
+	_pge_processOBJ = s->pgeProcessOBJ;
+	_pge_inpKeysMask = s->pgeInpKeysMask;
+	_pge_opTempVar1 = s->pgeOpTempVar1;
+	_pge_opTempVar2 = s->pgeOpTempVar2;
+	_pge_compareVar1 = s->pgeCompareVar1;
+	_pge_compareVar2 = s->pgeCompareVar2;
+	memcpy(_pgeLive, s->pgeLive, sizeof(_pgeLive));
+	for (int i = 0; i < 256; ++i) {
+		LivePGE *pge = &_pgeLive[i];
+		pge->next_PGE_in_room = indexToPtr(pge->next_PGE_in_room, _pgeLive);
+		pge->init_PGE = indexToPtr(pge->init_PGE, _res._pgeInit);
+	}
+	memcpy(&_pgeHot, &s->pgeHot, sizeof(_pgeHot));
+	memcpy(_pge_activeMask, s->pgeActiveMask, sizeof(_pge_activeMask));
+	for (int i = 0; i < 256; ++i) {
+		_pge_liveTable1[i] = indexToPtr(s->pgeLiveTable1[i], _pgeLive);
+	}
+	memcpy(_pge_groups, s->pgeGroups, sizeof(_pge_groups));
+	for (int i = 0; i < 256; ++i) {
+		_pge_groups[i].next_entry = indexToPtr(_pge_groups[i].next_entry, _pge_groups);
+		_pge_groupsTable[i] = indexToPtr(s->pgeGroupsTable[i], _pge_groups);
+	}
+	_pge_nextFreeGroup = indexToPtr(s->pgeNextFreeGroup, _pge_groups);
+
+	_col_curPos = s->colCurPos;
+	memcpy(_col_slots, s->colSlots, sizeof(_col_slots));
+	for (int i = 0; i < 256; ++i) {
+		CollisionSlot *slot = &_col_slots[i];
+		slot->prev_slot = indexToPtr(slot->prev_slot, _col_slots);
+		slot->live_pge = indexToPtr(slot->live_pge, _pgeLive);
+		_col_slotsTable[i] = indexToPtr(s->colSlotsTable[i], _col_slots);
+	}
+	_col_curSlot = indexToPtr(s->colCurSlot, _col_slots);
+	memcpy(_col_slots2, s->colSlots2, sizeof(_col_slots2));
+	for (int i = 0; i < 256; ++i) {
+		CollisionSlot2 *slot2 = &_col_slots2[i];
+		slot2->next_slot = indexToPtr(slot2->next_slot, _col_slots2);
+		slot2->unk2 = indexToPtr(slot2->unk2, _res._ctData);
+	}
+	_col_slots2Cur = indexToPtr(s->colSlots2Cur, _col_slots2);
+	_col_slots2Next = indexToPtr(s->colSlots2Next, _col_slots2);
+	memcpy(_col_activeCollisionSlots, s->colActiveCollisionSlots, sizeof(_col_activeCollisionSlots));
+	_col_currentLeftRoom = s->colCurrentLeftRoom;
+	_col_currentRightRoom = s->colCurrentRightRoom;
+	_col_currentPiegeGridPosX = s->colCurrentPiegeGridPosX;
+	_col_currentPiegeGridPosY = s->colCurrentPiegeGridPosY;
+	memcpy(_res._ctData, s->ctData, sizeof(_res._ctData));
+	// rebuild the grid index of the collision slots
+	++_col_gridEpoch;
+	if (_col_gridEpoch == 0) {
+		memset(_col_gridEpochs, 0, sizeof(_col_gridEpochs));
+		_col_gridEpoch = 1;
+	}
+	for (int i = 0; i < _col_curPos; ++i) {
+		const int16_t pos = _col_slotsTable[i]->ct_pos;
+		_col_gridSlots[pos] = i;
+		_col_gridEpochs[pos] = _col_gridEpoch;
+	}
+
+	_inp_lastKeysHit = s->inpLastKeysHit;
+	_inp_lastKeysHitLeftRight = s->inpLastKeysHitLeftRight;
+	_inp_demPos = s->inpDemPos;
+}
+
+void Game::benchmarkSnapshot() {
+	static const int kIterations = 1000;
+	GameSnapshot *s1 = (GameSnapshot *)calloc(1, sizeof(GameSnapshot));
+	GameSnapshot *s2 = (GameSnapshot *)calloc(1, sizeof(GameSnapshot));
+	if (!s1 || !s2) {
+		warning("Unable to allocate snapshots");
+	} else {
+		uint64_t saveTime = 0, restoreTime = 0;
+		for (int i = 0; i < kIterations; ++i) {
+			uint64_t t = getTimeNs();
+			saveSnapshot(s1);
+			saveTime += getTimeNs() - t;
+			t = getTimeNs();
+			restoreSnapshot(s1);
+			restoreTime += getTimeNs() - t;
+		}
+		saveSnapshot(s2);
+		const bool match = (memcmp(s1, s2, sizeof(GameSnapshot)) == 0);
+		printf("  snapshot: %d bytes, save %.1f us, restore %.1f us, round trip %s\n", (int)sizeof(GameSnapshot),
+			saveTime / 1000. / kIterations, restoreTime / 1000. / kIterations, match ? "ok" : "MISMATCH");
+	}
+	free(s1);
+	free(s2);
+}
+
+void Game::initRewind() {
+	_rewinding = false;
+	_rewindFrames = 0;
+	_rewindTime = 0;
+	_rewindState = 0;
+	if (_options.enable_rewind) {
+		_rewindState = (GameSnapshot *)calloc(1, sizeof(GameSnapshot));
+		if (!_rewindState || !_rewind.init(sizeof(GameSnapshot))) {
+			warning("Unable to allocate rewind buffer");
+			free(_rewindState);
+			_rewindState = 0;
+		}
+	}
+}
+
+void Game::finiRewind() {
+	if (_rewindState) {
+		_rewind.fini();
+		free(_rewindState);
+		_rewindState = 0;
+	}
+}
+
+void Game::pushRewindFrame() {
+	const uint64_t t = getTimeNs();
+	saveSnapshot(_rewindState);
+	_rewind.push((const uint8_t *)_rewindState);
+	_rewindTime += getTimeNs() - t;
+	++_rewindFrames;
+}
+
+void Game::printRewindStats() {
+	debug(DBG_INFO, "Rewind buffer: %d frames (%d keyframes), %.1f KB, %.1f us per frame", _rewind._count, _rewind._keyframesCount,
+		_rewind._dataSize / 1024., _rewindFrames ? _rewindTime / 1000. / _rewindFrames : 0.);
+}
+
+bool Game::initStateHash() {
+	_hashFrame = 0;
+	_hashDivergedFrame = -1;
+	_hashState = (uint8_t *)malloc(kStateHashBufferSize);
+	if (!_hashState) {
+		warning("Unable to allocate state hash buffer");
+		return false;
+	}
+	if (_hashTracePath) {
+		_hashTraceFile = fopen(_hashTracePath, "w");
+		if (!_hashTraceFile) {
+			warning("Unable to open hash trace file '%s'", _hashTracePath);
+		}
+	}
+	if (_hashComparePath) {
+		_hashCompareFile = fopen(_hashComparePath, "r");
+		if (!_hashCompareFile) {
+			warning("Unable to open hash trace file '%s'", _hashComparePath);
+		}
+	}
+	return true;
+}
+
+void Game::finiStateHash() {
+	if (_hashCompareFile) {
+		if (_hashDivergedFrame < 0) {
+			printf("State hashes match the trace for %u frames\n", _hashFrame);
+		}
+		fclose(_hashCompareFile);
+		_hashCompareFile = 0;
+	}
+	if (_hashTraceFile) {
+		fclose(_hashTraceFile);
+		_hashTraceFile = 0;
+	}
+	free(_hashState);
+	_hashState = 0;
+}
+
+// the hashed state is serialized field by field as fixed-width little endian values, pointers
+// as (index + 1). Only the simulation state is included, the cutscene, input and drawing fields
+// and the unused collision slots are left out, so the hashes do not depend on the compiler, the
+// pointers size or the structures layout.
+struct StateSerializer {
+	uint8_t *_p, *_end;
+
+	StateSerializer(uint8_t *buf, int size)
+		: _p(buf), _end(buf + size) {
+	}
+	void writeByte(uint8_t n) {
+		assert(_p < _end);
+		*_p++ = n;
+	}
+	void writeUint16(uint16_t n) {
+		writeByte(n & 255);
+		writeByte(n >> 8);
+	}
+	void writeUint32(uint32_t n) {
+		writeUint16(n & 0xFFFF);
+		writeUint16(n >> 16);
+	}
+	template<typename T>
+	void writeIndex(const T *p, const T *base) {
+		writeUint16(p ? (p - base + 1) : 0);
+	}
+};
+
+uint64_t Game::hashGameState(uint8_t *buf) {
+	StateSerializer s(buf, kStateHashBufferSize);
+	s.writeByte(_currentLevel);
+	s.writeByte(_skillLevel);
+	s.writeUint32(_score);
+	s.writeByte(_currentRoom);
+	s.writeByte(_loadMap);
+	s.writeUint32(_randSeed);
+	s.writeUint16(_deathCutsceneCounter);
+	s.writeByte(_saveStateCompleted);
+	s.writeByte(_validSaveState);
+	s.writeByte(_pge_processOBJ);
+	s.writeUint16(_pge_opTempVar1);
+	s.writeUint16(_pge_opTempVar2);
+	s.writeUint16(_pge_compareVar1);
+	s.writeUint16(_pge_compareVar2);
+
+	const int pgeNum = _res._pgeNum;
+	for (int i = 0; i < pgeNum; ++i) {
+		const LivePGE *pge = &_pgeLive[i];
+		s.writeUint16(pge->life);
+		s.writeUint16(pge->counter_value);
+		s.writeByte(pge->collision_slot);
+		s.writeByte(pge->next_inventory_PGE);
+		s.writeByte(pge->current_inventory_PGE);
+		s.writeByte(pge->unkF);
+		s.writeUint16(pge->anim_number);
+		s.writeByte(pge->index);
+		s.writeUint16(pge->first_obj_number);
+		s.writeIndex(pge->next_PGE_in_room, _pgeLive);
+		s.writeIndex(pge->init_PGE, _res._pgeInit);
+		s.writeUint16(_pgeHot.obj_type[i]);
+		s.writeUint16(_pgeHot.pos_x[i]);
+		s.writeUint16(_pgeHot.pos_y[i]);
+		s.writeByte(_pgeHot.anim_seq[i]);
+		s.writeByte(_pgeHot.room_location[i]);
+		s.writeByte(_pgeHot.flags[i]);
+		s.writeByte((_pge_activeMask[i >> 5] >> (i & 31)) & 1);
+		// the groups of the piege, in list order
+		for (const GroupPGE *le = _pge_groupsTable[i]; le; le = le->next_entry) {
+			s.writeUint16(le->index);
+			s.writeUint16(le->group_id);
+		}
+		s.writeUint16(0xFFFF);
+	}
+	for (int i = 0; i < 256; ++i) {
+		s.writeIndex(_pge_liveTable1[i], _pgeLive);
+	}
+
+	s.writeByte(_col_curPos);
+	for (const CollisionSlot *slot = _col_slots; slot < _col_curSlot; ++slot) {
+		s.writeUint16(slot->ct_pos);
+		s.writeIndex(slot->prev_slot, _col_slots);
+		s.writeIndex(slot->live_pge, _pgeLive);
+		s.writeUint16(slot->index);
+	}
+	s.writeIndex(_col_curSlot, _col_slots);
+	for (int i = 0; i < _col_curPos; ++i) {
+		s.writeIndex(_col_slotsTable[i], _col_slots);
+	}
+	if (_col_slots2Cur) {
+		for (const CollisionSlot2 *slot2 = _col_slots2; slot2 < _col_slots2Cur; ++slot2) {
+			s.writeIndex(slot2->next_slot, _col_slots2);
+			s.writeIndex(slot2->unk2, _res._ctData);
+			s.writeByte(slot2->data_size);
+			for (int i = 0; i <= slot2->data_size && i < (int)sizeof(slot2->data_buf); ++i) {
+				s.writeByte(slot2->data_buf[i]);
+			}
+		}
+	}
+	s.writeIndex(_col_slots2Cur, _col_slots2);
+	s.writeIndex(_col_slots2Next, _col_slots2);
+	for (int i = 0; i < (int)sizeof(_res._ctData); ++i) {
+		s.writeByte(_res._ctData[i]);
+	}
+	return hashXXH64(buf, s._p - buf, 0);
+}
+
+void Game::hashFrameState() {
+	const uint64_t hash = hashGameState(_hashState);
+	if (_hashTraceFile) {
+		fprintf(_hashTraceFile, "%u %d %d %016llx\n", _hashFrame, _currentLevel, _currentRoom, (unsigned long long)hash);
+	}
+	if (_hashCompareFile && _hashDivergedFrame < 0) {
+		unsigned int frame;
+		int level, room;
+		unsigned long long refHash;
+		if (fscanf(_hashCompareFile, "%u %d %d %llx", &frame, &level, &room, &refHash) != 4) {
+			printf("Hash trace ends at frame %u\n", _hashFrame);
+			_hashDivergedFrame = _hashFrame;
+		} else if (frame != _hashFrame || refHash != hash) {
+			printf("State diverges at frame %u (level %d room %d), expected level %d room %d\n", _hashFrame, _currentLevel, _currentRoom, level, room);
+			_hashDivergedFrame = _hashFrame;
+		}
+	}
+	++_hashFrame;
+}
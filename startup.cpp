@@ -0,0 +1,91 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include <SDL.h>
+#include "fs.h"
+#include "game.h"
+#include "util.h"
+
+struct StartupTask {
+	Game *game;
+	const char *name;
+	void (Game::*proc)();
+	uint64_t duration;
+	SDL_Thread *thread;
+};
+
+static void runStartupTask(StartupTask *task) {
+	const uint64_t t = getTimeNs();
+	(task->game->*(task->proc))();
+	task->duration = getTimeNs() - t;
+}
+
+static int startupTaskThread(void *param) {
+	runStartupTask((StartupTask *)param);
+	return 0;
+}
+
+void Game::startupLoadResources() {
+	_res.init();
+	switch (_res._type) {
+	case kResourceTypeAmiga:
+		_res.load("FONT8", Resource::OT_FNT, "SPR");
+		if (_res._isDemo) {
+			_cut._patchedOffsetsTable = Cutscene::_amigaDemoOffsetsTable;
+		}
+		break;
+	case kResourceTypeDOS:
+		_res.load("FB_TXT", Resource::OT_FNT);
+		if (_options.use_seq_cutscenes) {
+			_res._hasSeqData = _fs->exists("INTRO.SEQ");
+		}
+		if (_fs->exists("logosssi.cmd")) {
+			_cut._patchedOffsetsTable = Cutscene::_ssiOffsetsTable;
+		}
+		break;
+	}
+	loadGlobalBanks();
+	_globalBanksLoaded = true;
+}
+
+void Game::startupLoadTexts() {
+	_res.load_TEXT();
+}
+
+void Game::startupInitAudio() {
+	_mix.init();
+	_mix._mod._isAmiga = _res.isAmiga();
+}
+
+void Game::runStartupTasks() {
+	// the resources task goes through Resource::load, which shares the entry name and the .ABA file
+	// handle between all loads ; the texts and the audio device do not depend on anything it loads
+	StartupTask tasks[] = {
+		{ this, "resources", &Game::startupLoadResources, 0, 0 },
+		{ this, "texts", &Game::startupLoadTexts, 0, 0 },
+		{ this, "audio", &Game::startupInitAudio, 0, 0 }
+	};
+	if (_startupParallel) {
+		for (int i = 1; i < ARRAYSIZE(tasks); ++i) {
+			tasks[i].thread = SDL_CreateThread(startupTaskThread, "Startup", &tasks[i]);
+			if (!tasks[i].thread) {
+				warning("Unable to create thread for startup task '%s'", tasks[i].name);
+			}
+		}
+	}
+	runStartupTask(&tasks[0]);
+	for (int i = 1; i < ARRAYSIZE(tasks); ++i) {
+		if (tasks[i].thread) {
+			SDL_WaitThread(tasks[i].thread, 0);
+		} else {
+			runStartupTask(&tasks[i]);
+		}
+	}
+	for (int i = 0; i < ARRAYSIZE(tasks); ++i) {
+		debug(DBG_GAME, "Startup task '%s' %.3f ms", tasks[i].name, tasks[i].duration / 1000000.);
+	}
+	markStartupEvent("startup tasks");
+}
@@ -0,0 +1,190 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include <SDL.h>
+#include <sys/param.h>
+#include "file.h"
+#include "state_writer.h"
+#include "util.h"
+
+static int writerThread(void *param) {
+	((StateWriter *)param)->processRequests();
+	return 0;
+}
+
+StateWriter::StateWriter()
+	: _thread(0), _mutex(0), _cond(0), _quit(false), _pendingHead(0), _pendingTail(0), _current(0), _completed(0) {
+}
+
+void StateWriter::init() {
+	_quit = false;
+	_mutex = SDL_CreateMutex();
+	_cond = SDL_CreateCond();
+	if (_mutex && _cond) {
+		_thread = SDL_CreateThread(writerThread, "StateWriter", this);
+	}
+	if (!_thread) {
+		warning("Unable to create state writer thread, saving synchronously");
+	}
+}
+
+void StateWriter::fini() {
+	if (_thread) {
+		SDL_LockMutex(_mutex);
+		_quit = true;
+		SDL_CondBroadcast(_cond);
+		SDL_UnlockMutex(_mutex);
+		SDL_WaitThread(_thread, 0);
+		_thread = 0;
+	}
+	while (_completed) {
+		Request *next = _completed->next;
+		free(_completed);
+		_completed = next;
+	}
+	if (_cond) {
+		SDL_DestroyCond(_cond);
+		_cond = 0;
+	}
+	if (_mutex) {
+		SDL_DestroyMutex(_mutex);
+		_mutex = 0;
+	}
+}
+
+void StateWriter::queue(const char *name, const char *directory, int slot, uint8_t *data, uint32_t size) {
+	Request *r = (Request *)malloc(sizeof(Request));
+	if (!r) {
+		warning("Unable to allocate state writer request");
+		free(data);
+		return;
+	}
+	strncpy(r->name, name, sizeof(r->name) - 1);
+	r->name[sizeof(r->name) - 1] = 0;
+	r->directory = directory;
+	r->slot = slot;
+	r->data = data;
+	r->size = size;
+	r->success = false;
+	r->next = 0;
+	if (!_thread) {
+		writeRequest(r);
+		r->next = _completed;
+		_completed = r;
+		return;
+	}
+	SDL_LockMutex(_mutex);
+	if (_pendingTail) {
+		_pendingTail->next = r;
+	} else {
+		_pendingHead = r;
+	}
+	_pendingTail = r;
+	SDL_CondBroadcast(_cond);
+	SDL_UnlockMutex(_mutex);
+}
+
+bool StateWriter::isPending(const char *name) const {
+	if (_current && strcmp(_current->name, name) == 0) {
+		return true;
+	}
+	for (const Request *r = _pendingHead; r; r = r->next) {
+		if (strcmp(r->name, name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void StateWriter::wait(const char *name) {
+	if (_thread) {
+		SDL_LockMutex(_mutex);
+		while (isPending(name)) {
+			SDL_CondWait(_cond, _mutex);
+		}
+		SDL_UnlockMutex(_mutex);
+	}
+}
+
+bool StateWriter::getCompleted(int *slot, bool *success) {
+	if (_thread) {
+		SDL_LockMutex(_mutex);
+	}
+	Request *r = _completed;
+	if (r) {
+		_completed = r->next;
+	}
+	if (_thread) {
+		SDL_UnlockMutex(_mutex);
+	}
+	if (!r) {
+		return false;
+	}
+	*slot = r->slot;
+	*success = r->success;
+	free(r);
+	return true;
+}
+
+void StateWriter::writeRequest(Request *r) {
+	// the compressed data is written to a temporary file first, a crash does not leave a truncated state file
+	char tmpName[kMaxNameLength + 4];
+	snprintf(tmpName, sizeof(tmpName), "%s.tmp", r->name);
+	File f;
+	if (!f.open(tmpName, "zwb", r->directory)) {
+		warning("Unable to save state file '%s'", r->name);
+	} else {
+		f.write(r->data, r->size);
+		const bool ioErr = f.ioErr();
+		f.close();
+		char tmpPath[MAXPATHLEN];
+		snprintf(tmpPath, sizeof(tmpPath), "%s/%s", r->directory, tmpName);
+		if (ioErr) {
+			warning("I/O error when saving game state");
+			remove(tmpPath);
+		} else {
+			char path[MAXPATHLEN];
+			snprintf(path, sizeof(path), "%s/%s", r->directory, r->name);
+#ifdef _WIN32
+			remove(path);
+#endif
+			if (rename(tmpPath, path) != 0) {
+				warning("Unable to rename '%s' to '%s'", tmpPath, path);
+				remove(tmpPath);
+			} else {
+				r->success = true;
+			}
+		}
+	}
+	free(r->data);
+	r->data = 0;
+}
+
+void StateWriter::processRequests() {
+	SDL_LockMutex(_mutex);
+	while (1) {
+		while (!_pendingHead && !_quit) {
+			SDL_CondWait(_cond, _mutex);
+		}
+		Request *r = _pendingHead;
+		if (!r) {
+			break;
+		}
+		_pendingHead = r->next;
+		if (!_pendingHead) {
+			_pendingTail = 0;
+		}
+		_current = r;
+		SDL_UnlockMutex(_mutex);
+		writeRequest(r);
+		SDL_LockMutex(_mutex);
+		_current = 0;
+		r->next = _completed;
+		_completed = r;
+		SDL_CondBroadcast(_cond);
+	}
+	SDL_UnlockMutex(_mutex);
+}
@@ -0,0 +1,54 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#ifndef STATE_WRITER_H__
+#define STATE_WRITER_H__
+
+#include "intern.h"
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+// writes the serialised game states to disk from a background thread
+
+struct StateWriter {
+	enum {
+		kMaxNameLength = 32
+	};
+
+	struct Request {
+		char name[kMaxNameLength];
+		const char *directory;
+		int slot;
+		uint8_t *data;
+		uint32_t size;
+		bool success;
+		Request *next;
+	};
+
+	SDL_Thread *_thread;
+	SDL_mutex *_mutex;
+	SDL_cond *_cond;
+	bool _quit;
+	Request *_pendingHead, *_pendingTail;
+	Request *_current;
+	Request *_completed;
+
+	StateWriter();
+
+	void init();
+	void fini();
+	void queue(const char *name, const char *directory, int slot, uint8_t *data, uint32_t size);
+	void wait(const char *name);
+	bool getCompleted(int *slot, bool *success);
+
+	bool isPending(const char *name) const;
+	void writeRequest(Request *r);
+	void processRequests();
+};
+
+#endif // STATE_WRITER_H__
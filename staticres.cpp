@@ -2658,6 +2658,186 @@ const Game::pge_OpcodeProc Game::_pge_opcodeTable[] = {
 	&Game::pge_op_isTempVar1Set
 };
 
+const int Game::_pge_opcodeTableSize = ARRAYSIZE(Game::_pge_opcodeTable);
+
+const char *Game::_pge_opcodeNames[] = {
+	/* 0x00 */
+	0,
+	"pge_op_isInpUp",
+	"pge_op_isInpBackward",
+	"pge_op_isInpDown",
+	/* 0x04 */
+	"pge_op_isInpForward",
+	"pge_op_isInpUpMod",
+	"pge_op_isInpBackwardMod",
+	"pge_op_isInpDownMod",
+	/* 0x08 */
+	"pge_op_isInpForwardMod",
+	"pge_op_isInpIdle",
+	"pge_op_isInpNoMod",
+	"pge_op_getCollision0u",
+	/* 0x0C */
+	"pge_op_getCollision00",
+	"pge_op_getCollision0d",
+	"pge_op_getCollision1u",
+	"pge_op_getCollision10",
+	/* 0x10 */
+	"pge_op_getCollision1d",
+	"pge_op_getCollision2u",
+	"pge_op_getCollision20",
+	"pge_op_getCollision2d",
+	/* 0x14 */
+	"pge_op_doesNotCollide0u",
+	"pge_op_doesNotCollide00",
+	"pge_op_doesNotCollide0d",
+	"pge_op_doesNotCollide1u",
+	/* 0x18 */
+	"pge_op_doesNotCollide10",
+	"pge_op_doesNotCollide1d",
+	"pge_op_doesNotCollide2u",
+	"pge_op_doesNotCollide20",
+	/* 0x1C */
+	"pge_op_doesNotCollide2d",
+	"pge_op_collides0o0d",
+	"pge_op_collides2o2d",
+	"pge_op_collides0o0u",
+	/* 0x20 */
+	"pge_op_collides2o2u",
+	"pge_op_collides2u2o",
+	"pge_op_isInGroup",
+	"pge_op_updateGroup0",
+	/* 0x24 */
+	"pge_op_updateGroup1",
+	"pge_op_updateGroup2",
+	"pge_op_updateGroup3",
+	"pge_op_isPiegeDead",
+	/* 0x28 */
+	"pge_op_collides1u2o",
+	"pge_op_collides1u1o",
+	"pge_op_collides1o1u",
+	"pge_o_unk0x2B",
+	/* 0x2C */
+	"pge_o_unk0x2C",
+	"pge_o_unk0x2D",
+	"pge_op_nop",
+	"pge_op_pickupObject",
+	/* 0x30 */
+	"pge_op_addItemToInventory",
+	"pge_op_copyPiege",
+	"pge_op_canUseCurrentInventoryItem",
+	"pge_op_removeItemFromInventory",
+	/* 0x34 */
+	"pge_o_unk0x34",
+	"pge_op_isInpMod",
+	"pge_op_setCollisionState1",
+	"pge_op_setCollisionState0",
+	/* 0x38 */
+	"pge_op_isInGroup1",
+	"pge_op_isInGroup2",
+	"pge_op_isInGroup3",
+	"pge_op_isInGroup4",
+	/* 0x3C */
+	"pge_o_unk0x3C",
+	"pge_o_unk0x3D",
+	"pge_op_setPiegeCounter",
+	"pge_op_decPiegeCounter",
+	/* 0x40 */
+	"pge_o_unk0x40",
+	"pge_op_wakeUpPiege",
+	"pge_op_removePiege",
+	"pge_op_removePiegeIfNotNear",
+	/* 0x44 */
+	"pge_op_loadPiegeCounter",
+	"pge_o_unk0x45",
+	"pge_o_unk0x46",
+	"pge_o_unk0x47",
+	/* 0x48 */
+	"pge_o_unk0x48",
+	"pge_o_unk0x49",
+	"pge_o_unk0x4A",
+	"pge_op_killPiege",
+	/* 0x4C */
+	"pge_op_isInCurrentRoom",
+	"pge_op_isNotInCurrentRoom",
+	"pge_op_scrollPosY",
+	"pge_op_playDefaultDeathCutscene",
+	/* 0x50 */
+	"pge_o_unk0x50",
+	0,
+	"pge_o_unk0x52",
+	"pge_o_unk0x53",
+	/* 0x54 */
+	"pge_op_isPiegeNear",
+	"pge_op_setLife",
+	"pge_op_incLife",
+	"pge_op_setPiegeDefaultAnim",
+	/* 0x58 */
+	"pge_op_setLifeCounter",
+	"pge_op_decLifeCounter",
+	"pge_op_playCutscene",
+	"pge_op_isTempVar2Set",
+	/* 0x5C */
+	"pge_op_playDeathCutscene",
+	"pge_o_unk0x5D",
+	"pge_o_unk0x5E",
+	"pge_o_unk0x5F",
+	/* 0x60 */
+	"pge_op_findAndCopyPiege",
+	"pge_op_isInRandomRange",
+	"pge_o_unk0x62",
+	"pge_o_unk0x63",
+	/* 0x64 */
+	"pge_o_unk0x64",
+	"pge_op_addToCredits",
+	"pge_op_subFromCredits",
+	"pge_o_unk0x67",
+	/* 0x68 */
+	"pge_op_setCollisionState2",
+	"pge_op_saveState",
+	"pge_o_unk0x6A",
+	"pge_op_isInGroupSlice",
+	/* 0x6C */
+	"pge_o_unk0x6C",
+	"pge_op_isCollidingObject",
+	"pge_o_unk0x6E",
+	"pge_o_unk0x6F",
+	/* 0x70 */
+	"pge_o_unk0x70",
+	"pge_o_unk0x71",
+	"pge_o_unk0x72",
+	"pge_o_unk0x73",
+	/* 0x74 */
+	"pge_op_collides4u",
+	"pge_op_doesNotCollide4u",
+	"pge_op_isBelowConrad",
+	"pge_op_isAboveConrad",
+	/* 0x78 */
+	"pge_op_isNotFacingConrad",
+	"pge_op_isFacingConrad",
+	"pge_op_collides2u1u",
+	"pge_op_displayText",
+	/* 0x7C */
+	"pge_o_unk0x7C",
+	"pge_op_playSound",
+	"pge_o_unk0x7E",
+	"pge_o_unk0x7F",
+	/* 0x80 */
+	"pge_op_setPiegePosX",
+	"pge_op_setPiegePosModX",
+	"pge_op_changeRoom",
+	"pge_op_hasInventoryItem",
+	/* 0x84 */
+	"pge_op_changeLevel",
+	"pge_op_shakeScreen",
+	"pge_o_unk0x86",
+	"pge_op_playSoundGroup",
+	/* 0x88 */
+	"pge_op_adjustPos",
+	0,
+	"pge_op_setTempVar1",
+	"pge_op_isTempVar1Set"
+};
+
 const uint8_t Game::_pge_modKeysTable[] = {
 	0x40, 0x10, 0x20
 };
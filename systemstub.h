@@ -9,6 +9,7 @@
 
 #include "intern.h"
 #include "scaler.h"
+#include "scheduler.h"
 
 struct PlayerInput {
 	enum {
@@ -20,7 +21,8 @@ struct PlayerInput {
 	enum {
 		DF_FASTMODE = 1 << 0,
 		DF_DBLOCKS  = 1 << 1,
-		DF_SETLIFE  = 1 << 2
+		DF_SETLIFE  = 1 << 2,
+		DF_PERFHUD  = 1 << 3
 	};
 
 	uint8_t dirMask;
@@ -35,14 +37,53 @@ struct PlayerInput {
 	bool save;
 	bool load;
 	int stateSlot;
+	bool rewind;
 
 	uint8_t dbgMask;
 	bool quit;
 };
 
+struct PerfStats {
+	enum {
+		PHASE_INPUT,
+		PHASE_LOGIC,
+		PHASE_DRAW,
+		PHASE_PRESENT,
+		PHASE_WAIT,
+		PHASE_MISC,
+		PHASES_COUNT
+	};
+
+	uint32_t phaseTime[PHASES_COUNT]; // us, Game::mainLoop
+	uint32_t bankHits, bankMisses;
+	uint32_t dirtyRects, dirtyArea; // last presented frame
+	uint32_t audioLoad; // callback duration in percents of the buffer period, written by the audio thread
+	uint32_t audioUnderruns;
+};
+
+struct AudioStats {
+	enum {
+		kHistogramBuckets = 16,
+		kDurationBucketPercent = 10, // callback duration, in percents of the buffer period
+		kIntervalBucketPercent = 25 // time between two callbacks
+	};
+
+	uint32_t period; // us, duration of the samples requested by a callback
+	uint32_t lastDuration, lastInterval; // us
+	uint32_t totalCallbacks, totalUnderruns; // since startAudio
+	// last minute
+	uint32_t callbacks, underruns;
+	uint32_t avgDuration, maxDuration, maxInterval; // us
+	uint32_t durationHistogram[kHistogramBuckets];
+	uint32_t intervalHistogram[kHistogramBuckets];
+};
+
+struct VideoCapture;
+
 struct ScalerParameters {
 	ScalerType type;
 	const Scaler *scaler;
+	DynLib *dynLib;
 	int factor;
 
 	static ScalerParameters defaults();
@@ -52,7 +93,13 @@ struct SystemStub {
 	typedef void (*AudioCallback)(void *param, int16_t *stream, int len);
 
 	PlayerInput _pi;
+	PerfStats _perf;
+	FrameScheduler _scheduler;
+	VideoCapture *_capture; // the screen is recorded by updateScreen
 
+	SystemStub()
+		: _capture(0) {
+	}
 	virtual ~SystemStub() {}
 
 	virtual void init(const char *title, int w, int h, bool fullscreen, ScalerParameters *scalerParameters) = 0;
@@ -69,6 +116,7 @@ struct SystemStub {
 
 	virtual void processEvents() = 0;
 	virtual void sleep(int duration) = 0;
+	virtual void sleepUntil(uint64_t timestamp) = 0; // getTimeNs() clock
 	virtual uint32_t getTimeStamp() = 0;
 
 	virtual void startAudio(AudioCallback callback, void *param) = 0;
@@ -76,6 +124,12 @@ struct SystemStub {
 	virtual uint32_t getOutputSampleRate() = 0;
 	virtual void lockAudio() = 0;
 	virtual void unlockAudio() = 0;
+	virtual void getAudioStats(AudioStats *stats) = 0;
+
+	// runs the game loop, on a separate thread when the stub keeps the main one for the presentation
+	virtual void runLoop(void (*proc)(void *param), void *param) {
+		proc(param);
+	}
 };
 
 struct LockAudioStack {
@@ -89,6 +143,7 @@ struct LockAudioStack {
 	SystemStub *_stub;
 };
 
-extern SystemStub *SystemStub_SDL_create();
+extern SystemStub *SystemStub_SDL_create(bool presentThread);
+extern SystemStub *SystemStub_Null_create();
 
 #endif // SYSTEMSTUB_H__
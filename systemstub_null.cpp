@@ -0,0 +1,161 @@
+
+/*
+ * REminiscence - Flashback interpreter
+ * Copyright (C) 2005-2015 Gregory Montoir (cyx@users.sourceforge.net)
+ */
+
+#include "capture.h"
+#include "systemstub.h"
+#include "util.h"
+
+static const int kAudioHz = 22050;
+
+// headless stub, no display nor audio output and sleep() returns immediately. The screen is
+// only kept when it is recorded.
+struct SystemStub_Null : SystemStub {
+	Color _palette[256];
+	uint8_t *_screen;
+	int _screenW, _screenH;
+	uint64_t _startTime;
+
+	virtual ~SystemStub_Null() {}
+	virtual void init(const char *title, int w, int h, bool fullscreen, ScalerParameters *scalerParameters);
+	virtual void destroy();
+	virtual void setScreenSize(int w, int h);
+	virtual void setPalette(const uint8_t *pal, int n);
+	virtual void setPaletteEntry(int i, const Color *c);
+	virtual void getPaletteEntry(int i, Color *c);
+	virtual void setOverscanColor(int i);
+	virtual void copyRect(int x, int y, int w, int h, const uint8_t *buf, int pitch);
+	virtual void fadeScreen();
+	virtual void updateScreen(int shakeOffset);
+	virtual void processEvents();
+	virtual void sleep(int duration);
+	virtual void sleepUntil(uint64_t timestamp);
+	virtual uint32_t getTimeStamp();
+	virtual void startAudio(AudioCallback callback, void *param);
+	virtual void stopAudio();
+	virtual uint32_t getOutputSampleRate();
+	virtual void lockAudio();
+	virtual void unlockAudio();
+	virtual void getAudioStats(AudioStats *stats);
+};
+
+SystemStub *SystemStub_Null_create() {
+	return new SystemStub_Null();
+}
+
+void SystemStub_Null::init(const char *title, int w, int h, bool fullscreen, ScalerParameters *scalerParameters) {
+	memset(&_pi, 0, sizeof(_pi));
+	memset(&_perf, 0, sizeof(_perf));
+	_scheduler.init(this);
+	memset(_palette, 0, sizeof(_palette));
+	_startTime = getTimeNs();
+	_screen = 0;
+	_screenW = _screenH = 0;
+	setScreenSize(w, h);
+}
+
+void SystemStub_Null::destroy() {
+	free(_screen);
+	_screen = 0;
+}
+
+void SystemStub_Null::setScreenSize(int w, int h) {
+	if (_screenW == w && _screenH == h) {
+		return;
+	}
+	free(_screen);
+	_screen = (uint8_t *)calloc(1, w * h);
+	if (!_screen) {
+		error("SystemStub_Null::setScreenSize() Unable to allocate screen, w=%d, h=%d", w, h);
+	}
+	_screenW = w;
+	_screenH = h;
+}
+
+void SystemStub_Null::setPalette(const uint8_t *pal, int n) {
+	assert(n <= 256);
+	for (int i = 0; i < n; ++i) {
+		_palette[i].r = pal[i * 3 + 0];
+		_palette[i].g = pal[i * 3 + 1];
+		_palette[i].b = pal[i * 3 + 2];
+	}
+}
+
+void SystemStub_Null::setPaletteEntry(int i, const Color *c) {
+	_palette[i] = *c;
+}
+
+void SystemStub_Null::getPaletteEntry(int i, Color *c) {
+	*c = _palette[i];
+}
+
+void SystemStub_Null::setOverscanColor(int i) {
+}
+
+void SystemStub_Null::copyRect(int x, int y, int w, int h, const uint8_t *buf, int pitch) {
+	if (!_capture) {
+		return;
+	}
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (y < 0) {
+		h += y;
+		y = 0;
+	}
+	if (x + w > _screenW) {
+		w = _screenW - x;
+	}
+	if (y + h > _screenH) {
+		h = _screenH - y;
+	}
+	for (int j = 0; j < h && w > 0; ++j) {
+		memcpy(_screen + (y + j) * _screenW + x, buf + (y + j) * pitch + x, w);
+	}
+}
+
+void SystemStub_Null::fadeScreen() {
+}
+
+void SystemStub_Null::updateScreen(int shakeOffset) {
+	if (_capture && _screenW >= _capture->_w && _screenH >= _capture->_h) {
+		const int offset = (_screenH - _capture->_h) / 2 * _screenW + (_screenW - _capture->_w) / 2;
+		_capture->pushFrame(_screen + offset, _screenW, _palette, getTimeStamp());
+	}
+}
+
+void SystemStub_Null::processEvents() {
+}
+
+void SystemStub_Null::sleep(int duration) {
+}
+
+void SystemStub_Null::sleepUntil(uint64_t timestamp) {
+}
+
+uint32_t SystemStub_Null::getTimeStamp() {
+	return (uint32_t)((getTimeNs() - _startTime) / 1000000);
+}
+
+void SystemStub_Null::startAudio(AudioCallback callback, void *param) {
+}
+
+void SystemStub_Null::stopAudio() {
+}
+
+uint32_t SystemStub_Null::getOutputSampleRate() {
+	return kAudioHz;
+}
+
+void SystemStub_Null::lockAudio() {
+}
+
+void SystemStub_Null::unlockAudio() {
+}
+
+void SystemStub_Null::getAudioStats(AudioStats *stats) {
+	memset(stats, 0, sizeof(AudioStats));
+}
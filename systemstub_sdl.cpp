@@ -5,12 +5,21 @@
  */
 
 #include <SDL.h>
+#include "audio_stats.h"
+#include "capture.h"
+#include "perf_hud.h"
 #include "scaler.h"
 #include "screenshot.h"
 #include "systemstub.h"
 #include "util.h"
 
 static const int kAudioHz = 22050;
+static const uint64_t kAudioStatsLogInterval = 10000000000ULL; // ns
+static const uint64_t kSleepSpinDuration = 2000000; // ns
+static const uint64_t kFadeDuration = 480000000; // ns
+static const int kFadeStepDelay = 30; // ms
+static const int kEventsPollDelay = 10; // ms
+static const int kEventsQueueSize = 256;
 
 static const char *kIconBmp = "icon.bmp";
 
@@ -23,33 +32,141 @@ ScalerParameters ScalerParameters::defaults() {
 	ScalerParameters params;
 	params.type = kScalerTypeInternal;
 	params.scaler = &_internalScaler;
+	params.dynLib = 0;
 	params.factor = _internalScaler.factorMin + (_internalScaler.factorMax - _internalScaler.factorMin) / 2;
 	return params;
 }
 
+// frame handed to the main thread, the indexed pixels of the whole screen and the
+// rectangles updated since the previous frame
+struct PresentFrame {
+	enum {
+		kRectsCount = 200
+	};
+
+	uint8_t *pixels;
+	uint32_t palette[256];
+	SDL_Rect rects[kRectsCount];
+	int rectsCount;
+	int shakeOffset;
+	bool fade;
+	uint8_t dbgMask;
+	PerfStats perf;
+};
+
+// palette indices used by each 8x8 block of the indexed screen, a palette change only
+// expands again the blocks using one of the modified colors
+struct PaletteUsage {
+	enum {
+		kBlockSize = 8,
+		kMaskSize = 256 / 32
+	};
+
+	uint32_t *_masks;
+	int _blocksW, _blocksH;
+
+	void init(int w, int h) {
+		_blocksW = (w + kBlockSize - 1) / kBlockSize;
+		_blocksH = (h + kBlockSize - 1) / kBlockSize;
+		_masks = (uint32_t *)calloc(_blocksW * _blocksH, kMaskSize * sizeof(uint32_t));
+		if (!_masks) {
+			error("PaletteUsage::init() Unable to allocate masks, w=%d, h=%d", w, h);
+		}
+		// the screen is cleared to color 0
+		for (int i = 0; i < _blocksW * _blocksH; ++i) {
+			_masks[i * kMaskSize] = 1;
+		}
+	}
+	void fini() {
+		free(_masks);
+		_masks = 0;
+	}
+	void update(const uint8_t *screen, int w, int h, const SDL_Rect *rect) {
+		const int bx1 = rect->x / kBlockSize;
+		const int by1 = rect->y / kBlockSize;
+		const int bx2 = (rect->x + rect->w - 1) / kBlockSize;
+		const int by2 = (rect->y + rect->h - 1) / kBlockSize;
+		for (int by = by1; by <= by2; ++by) {
+			const int y1 = by * kBlockSize;
+			const int y2 = MIN(y1 + kBlockSize, h);
+			for (int bx = bx1; bx <= bx2; ++bx) {
+				const int x1 = bx * kBlockSize;
+				const int x2 = MIN(x1 + kBlockSize, w);
+				uint32_t *mask = _masks + (by * _blocksW + bx) * kMaskSize;
+				memset(mask, 0, kMaskSize * sizeof(uint32_t));
+				for (int y = y1; y < y2; ++y) {
+					const uint8_t *p = screen + y * w;
+					for (int x = x1; x < x2; ++x) {
+						mask[p[x] >> 5] |= 1U << (p[x] & 31);
+					}
+				}
+			}
+		}
+	}
+	bool uses(int bx, int by, const uint32_t *colors) const {
+		const uint32_t *mask = _masks + (by * _blocksW + bx) * kMaskSize;
+		for (int i = 0; i < kMaskSize; ++i) {
+			if (mask[i] & colors[i]) {
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
 struct SystemStub_SDL : SystemStub {
 	SDL_Window *_window;
 	SDL_Renderer *_renderer;
 	SDL_Texture *_texture;
 	int _texW, _texH;
+	bool _directTexture; // the screen is expanded in the texture memory
 	SDL_GameController *_controller;
 	SDL_PixelFormat *_fmt;
 	const char *_caption;
-	uint32_t *_screenBuffer;
+	uint32_t *_screenBuffer; // not used by the point and linear scalers, except for the screenshots
 	bool _fullscreen;
 	uint8_t _overscanColor;
 	uint32_t _rgbPalette[256];
 	int _screenW, _screenH;
 	SDL_Joystick *_joystick;
-	SDL_Rect _blitRects[200];
+	SDL_Rect _blitRects[PresentFrame::kRectsCount];
 	int _numBlitRects;
+	bool _presentThread;
+	bool _gameThreaded; // the game loop runs on _gameThread, the window and the renderer stay on the main thread
+	SDL_Thread *_gameThread;
+	void (*_gameProc)(void *);
+	void *_gameParam;
+	SDL_mutex *_mailboxMutex;
+	SDL_cond *_mailboxCond;
+	PresentFrame _frames[3]; // triple buffering: game thread, pending and main thread
+	int _backFrame, _pendingFrame, _frontFrame;
+	bool _framePending;
+	bool _gameDone;
+	SDL_Event _events[kEventsQueueSize]; // polled by the main thread, processed by the game thread
+	int _eventsHead, _eventsCount;
+	int _screenSizeRequestW, _screenSizeRequestH;
+	uint8_t *_indexedScreen; // game thread copy of the screen
+	PaletteUsage _paletteUsage; // presentation side
+	uint32_t _presentedPalette[256];
 	bool _fadeOnUpdateScreen;
+	bool _fadeActive; // presentation side
+	uint64_t _fadeStartTime;
+	uint64_t _renderTime;
+	int _presentedShakeOffset;
+	bool _presentedPerfHud;
 	void (*_audioCbProc)(void *, int16_t *, int);
 	void *_audioCbData;
 	int _screenshot;
+	ScreenshotWriter _screenshotWriter;
+	SDL_Texture *_hudTexture;
+	PerfHud _hud;
+	uint32_t _dirtyRects, _dirtyArea;
+	AudioTelemetry _audioTelemetry;
+	uint64_t _audioStatsLogTimestamp;
 	ScalerType _scalerType;
 	const Scaler *_scaler;
 	int _scaleFactor;
+	ScalerBuffer _scalerBuffer; // presentation side
 
 	virtual ~SystemStub_SDL() {}
 	virtual void init(const char *title, int w, int h, bool fullscreen, ScalerParameters *scalerParameters);
@@ -64,23 +181,48 @@ struct SystemStub_SDL : SystemStub {
 	virtual void updateScreen(int shakeOffset);
 	virtual void processEvents();
 	virtual void sleep(int duration);
+	virtual void sleepUntil(uint64_t timestamp);
 	virtual uint32_t getTimeStamp();
 	virtual void startAudio(AudioCallback callback, void *param);
 	virtual void stopAudio();
 	virtual uint32_t getOutputSampleRate();
 	virtual void lockAudio();
 	virtual void unlockAudio();
+	virtual void getAudioStats(AudioStats *stats);
+	virtual void runLoop(void (*proc)(void *param), void *param);
 
+	void resizeScreen(int w, int h);
+	bool nextEvent(SDL_Event *ev);
+	void queueEvent(const SDL_Event &ev);
+	bool processWindowEvent(const SDL_Event &ev);
 	void processEvent(const SDL_Event &ev, bool &paused);
 	void prepareGraphics();
 	void cleanupGraphics();
 	void changeGraphics(bool fullscreen, int scaleFactor);
+	void createRenderer();
+	void destroyRenderer();
+	void presentationLoop();
+	void publishFrame(int shakeOffset);
+	void presentFrame(const PresentFrame *frame);
+	void redrawPresentedFrame();
+	void presentScreen(int shakeOffset, bool fade, bool perfHud, const PerfStats *perf);
+	void renderScreen(const PerfStats *perf);
+	void queueScreenshot(int type, int num, const uint8_t *pixels);
+	void captureScreen();
 	void forceGraphicsRedraw();
-	void drawRect(SDL_Rect *rect, uint8_t color);
+	void drawPerfHud(const PerfStats *perf);
+	void expandRect(const SDL_Rect *rect, const uint8_t *buf, const uint32_t *palette, uint8_t dbgMask);
+	void expandPixels(const SDL_Rect *rect, const uint8_t *buf, const uint32_t *palette, uint8_t dbgMask);
+	void expandPaletteChanges(const uint8_t *buf, const uint32_t *palette, uint8_t dbgMask, SDL_Rect *bounds);
+	void updateTexture(const uint8_t *pixels, const uint32_t *palette, const SDL_Rect *rects, int rectsCount, uint8_t dbgMask);
+
+	static int gameThread(void *param);
 };
 
-SystemStub *SystemStub_SDL_create() {
-	return new SystemStub_SDL();
+SystemStub *SystemStub_SDL_create(bool presentThread) {
+	SystemStub_SDL *stub = new SystemStub_SDL();
+	stub->_presentThread = presentThread;
+	return stub;
 }
 
 void SystemStub_SDL::init(const char *title, int w, int h, bool fullscreen, ScalerParameters *scalerParameters) {
@@ -88,13 +230,34 @@ void SystemStub_SDL::init(const char *title, int w, int h, bool fullscreen, Scal
 	SDL_ShowCursor(SDL_DISABLE);
 	_caption = title;
 	memset(&_pi, 0, sizeof(_pi));
+	memset(&_perf, 0, sizeof(_perf));
+	_scheduler.init(this);
 	_screenBuffer = 0;
+	_indexedScreen = 0;
+	_paletteUsage._masks = 0;
+	memset(_frames, 0, sizeof(_frames));
+	_gameThreaded = false;
+	_gameThread = 0;
+	if (_presentThread) {
+		_mailboxMutex = SDL_CreateMutex();
+		_mailboxCond = SDL_CreateCond();
+		if (!_mailboxMutex || !_mailboxCond) {
+			warning("SystemStub_SDL::init() Unable to create the game thread mailbox");
+			_presentThread = false;
+		}
+	}
 	_fadeOnUpdateScreen = false;
+	_fadeActive = false;
+	_dirtyRects = _dirtyArea = 0;
+	_audioTelemetry.reset();
+	_audioStatsLogTimestamp = 0;
 	_fullscreen = fullscreen;
 	_scalerType = scalerParameters->type;
 	_scaler = scalerParameters->scaler;
 	_scaleFactor = scalerParameters->factor;
+	memset(&_scalerBuffer, 0, sizeof(_scalerBuffer));
 	memset(_rgbPalette, 0, sizeof(_rgbPalette));
+	_fmt = SDL_AllocFormat(kPixelFormat);
 	_screenW = _screenH = 0;
 	setScreenSize(w, h);
 	_joystick = 0;
@@ -109,10 +272,14 @@ void SystemStub_SDL::init(const char *title, int w, int h, bool fullscreen, Scal
 		}
 	}
 	_screenshot = 1;
+	_screenshotWriter.init();
 }
 
 void SystemStub_SDL::destroy() {
 	cleanupGraphics();
+	SDL_FreeFormat(_fmt);
+	_fmt = 0;
+	_screenshotWriter.fini();
 	if (_controller) {
 		SDL_GameControllerClose(_controller);
 		_controller = 0;
@@ -121,6 +288,10 @@ void SystemStub_SDL::destroy() {
 		SDL_JoystickClose(_joystick);
 		_joystick = 0;
 	}
+	if (_presentThread) {
+		SDL_DestroyCond(_mailboxCond);
+		SDL_DestroyMutex(_mailboxMutex);
+	}
 	SDL_Quit();
 }
 
@@ -128,15 +299,48 @@ void SystemStub_SDL::setScreenSize(int w, int h) {
 	if (_screenW == w && _screenH == h) {
 		return;
 	}
+	if (_gameThreaded) {
+		// the window and the renderer are recreated by the main thread, the game thread waits for the new buffers
+		SDL_LockMutex(_mailboxMutex);
+		_screenSizeRequestW = w;
+		_screenSizeRequestH = h;
+		SDL_CondBroadcast(_mailboxCond);
+		while (_screenSizeRequestW != 0) {
+			SDL_CondWait(_mailboxCond, _mailboxMutex);
+		}
+		SDL_UnlockMutex(_mailboxMutex);
+		return;
+	}
+	resizeScreen(w, h);
+}
+
+void SystemStub_SDL::resizeScreen(int w, int h) {
 	cleanupGraphics();
 	const int screenBufferSize = w * h * sizeof(uint32_t);
 	_screenBuffer = (uint32_t *)calloc(1, screenBufferSize);
 	if (!_screenBuffer) {
 		error("SystemStub_SDL::setScreenSize() Unable to allocate offscreen buffer, w=%d, h=%d", w, h);
 	}
+	_indexedScreen = (uint8_t *)calloc(1, w * h);
+	if (!_indexedScreen) {
+		error("SystemStub_SDL::setScreenSize() Unable to allocate indexed screen, w=%d, h=%d", w, h);
+	}
+	_paletteUsage.init(w, h);
+	memset(_presentedPalette, 0, sizeof(_presentedPalette));
+	if (_presentThread) {
+		bool allocated = true;
+		for (int i = 0; i < 3; ++i) {
+			_frames[i].pixels = (uint8_t *)calloc(1, w * h);
+			allocated = allocated && (_frames[i].pixels != 0);
+		}
+		if (!allocated) {
+			error("SystemStub_SDL::setScreenSize() Unable to allocate indexed frames, w=%d, h=%d", w, h);
+		}
+	}
 	_screenW = w;
 	_screenH = h;
 	prepareGraphics();
+	forceGraphicsRedraw();
 }
 
 void SystemStub_SDL::setPalette(const uint8_t *pal, int n) {
@@ -194,75 +398,371 @@ void SystemStub_SDL::copyRect(int x, int y, int w, int h, const uint8_t *buf, in
 		br->w = w;
 		br->h = h;
 		++_numBlitRects;
+		++_dirtyRects;
+		_dirtyArea += w * h;
 
-		uint32_t *p = _screenBuffer + br->y * _screenW + br->x;
+		// expanded when the screen is updated
+		uint8_t *p = _indexedScreen + y * _screenW + x;
 		buf += y * pitch + x;
-
 		while (h--) {
-			for (int i = 0; i < w; ++i) {
-				p[i] = _rgbPalette[buf[i]];
-			}
+			memcpy(p, buf, w);
 			p += _screenW;
 			buf += pitch;
 		}
-		if (_pi.dbgMask & PlayerInput::DF_DBLOCKS) {
-			drawRect(br, 0xE7);
-		}
 	}
 }
 
-void SystemStub_SDL::fadeScreen() {
-	_fadeOnUpdateScreen = true;
+static void extendBounds(SDL_Rect *bounds, const SDL_Rect *r) {
+	if (bounds->w == 0) {
+		*bounds = *r;
+	} else {
+		const int x2 = MAX(bounds->x + bounds->w, r->x + r->w);
+		const int y2 = MAX(bounds->y + bounds->h, r->y + r->h);
+		bounds->x = MIN(bounds->x, r->x);
+		bounds->y = MIN(bounds->y, r->y);
+		bounds->w = x2 - bounds->x;
+		bounds->h = y2 - bounds->y;
+	}
 }
 
-void SystemStub_SDL::updateScreen(int shakeOffset) {
+static void drawRect(uint32_t *dst, int pitch, int w, int h, uint32_t color) {
+	for (int i = 0; i < w; ++i) {
+		dst[i] = dst[(h - 1) * pitch + i] = color;
+	}
+	for (int j = 0; j < h; ++j) {
+		dst[j * pitch] = dst[j * pitch + w - 1] = color;
+	}
+}
+
+void SystemStub_SDL::updateTexture(const uint8_t *pixels, const uint32_t *palette, const SDL_Rect *rects, int rectsCount, uint8_t dbgMask) {
+	if (_directTexture) {
+		// the palette indices are expanded in the texture memory. The locked area is written
+		// entirely from the indexed screen, the texture previous pixels are not read back
+		SDL_Rect bounds;
+		bounds.x = bounds.y = bounds.w = bounds.h = 0;
+		for (int i = 0; i < rectsCount; ++i) {
+			_paletteUsage.update(pixels, _screenW, _screenH, &rects[i]);
+			extendBounds(&bounds, &rects[i]);
+		}
+		expandPaletteChanges(pixels, palette, dbgMask, &bounds);
+		if (bounds.w == 0) {
+			return;
+		}
+		void *dst = 0;
+		int pitch = 0;
+		if (SDL_LockTexture(_texture, &bounds, &dst, &pitch) == 0) {
+			assert((pitch & 3) == 0);
+			pitch /= sizeof(uint32_t);
+			uint32_t *p = (uint32_t *)dst;
+			const uint8_t *src = pixels + bounds.y * _screenW + bounds.x;
+			for (int h = bounds.h; h > 0; --h) {
+				for (int i = 0; i < bounds.w; ++i) {
+					p[i] = palette[src[i]];
+				}
+				p += pitch;
+				src += _screenW;
+			}
+			if (dbgMask & PlayerInput::DF_DBLOCKS) {
+				for (int i = 0; i < rectsCount; ++i) {
+					const SDL_Rect *r = &rects[i];
+					drawRect((uint32_t *)dst + (r->y - bounds.y) * pitch + (r->x - bounds.x), pitch, r->w, r->h, palette[0xE7]);
+				}
+			}
+			SDL_UnlockTexture(_texture);
+		}
+		return;
+	}
+	for (int i = 0; i < rectsCount; ++i) {
+		expandRect(&rects[i], pixels, palette, dbgMask);
+	}
+	expandPaletteChanges(pixels, palette, dbgMask, 0);
 	if (_texW != _screenW || _texH != _screenH) {
 		void *dst = 0;
 		int pitch = 0;
 		if (SDL_LockTexture(_texture, 0, &dst, &pitch) == 0) {
 			assert((pitch & 3) == 0);
-			_scaler->scale(_scaleFactor, (uint32_t *)dst, pitch / sizeof(uint32_t), _screenBuffer, _screenW, _screenW, _screenH);
+			scaleWithBuffer(_scaler, &_scalerBuffer, _scaleFactor, (uint32_t *)dst, pitch / sizeof(uint32_t), _screenBuffer, _screenW, _screenW, _screenH);
 			SDL_UnlockTexture(_texture);
 		}
 	} else {
 		SDL_UpdateTexture(_texture, 0, _screenBuffer, _screenW * sizeof(uint32_t));
 	}
-	SDL_RenderClear(_renderer);
-	if (_fadeOnUpdateScreen) {
-		SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_BLEND);
-		SDL_Rect r;
-		r.x = r.y = 0;
-		SDL_GetRendererOutputSize(_renderer, &r.w, &r.h);
-		for (int i = 1; i <= 16; ++i) {
-			SDL_SetRenderDrawColor(_renderer, 0, 0, 0, 256 - i * 16);
-			SDL_RenderCopy(_renderer, _texture, 0, 0);
-			SDL_RenderFillRect(_renderer, &r);
-			SDL_RenderPresent(_renderer);
-			SDL_Delay(30);
+}
+
+void SystemStub_SDL::expandRect(const SDL_Rect *rect, const uint8_t *buf, const uint32_t *palette, uint8_t dbgMask) {
+	_paletteUsage.update(buf, _screenW, _screenH, rect);
+	expandPixels(rect, buf, palette, dbgMask);
+}
+
+void SystemStub_SDL::expandPixels(const SDL_Rect *rect, const uint8_t *buf, const uint32_t *palette, uint8_t dbgMask) {
+	uint32_t *p = _screenBuffer + rect->y * _screenW + rect->x;
+	buf += rect->y * _screenW + rect->x;
+	for (int h = rect->h; h > 0; --h) {
+		for (int i = 0; i < rect->w; ++i) {
+			p[i] = palette[buf[i]];
+		}
+		p += _screenW;
+		buf += _screenW;
+	}
+	if (dbgMask & PlayerInput::DF_DBLOCKS) {
+		drawRect(_screenBuffer + rect->y * _screenW + rect->x, _screenW, rect->w, rect->h, palette[0xE7]);
+	}
+}
+
+void SystemStub_SDL::expandPaletteChanges(const uint8_t *buf, const uint32_t *palette, uint8_t dbgMask, SDL_Rect *bounds) {
+	uint32_t colors[PaletteUsage::kMaskSize];
+	memset(colors, 0, sizeof(colors));
+	bool changed = false;
+	for (int i = 0; i < 256; ++i) {
+		if (palette[i] != _presentedPalette[i]) {
+			colors[i >> 5] |= 1U << (i & 31);
+			changed = true;
+		}
+	}
+	if (!changed) {
+		return;
+	}
+	memcpy(_presentedPalette, palette, sizeof(_presentedPalette));
+	// the blocks using the modified colors, merged horizontally. With the bounds, the blocks are
+	// only added to the area to expand
+	for (int by = 0; by < _paletteUsage._blocksH; ++by) {
+		int bx = 0;
+		while (bx < _paletteUsage._blocksW) {
+			if (!_paletteUsage.uses(bx, by, colors)) {
+				++bx;
+				continue;
+			}
+			const int bx1 = bx;
+			do {
+				++bx;
+			} while (bx < _paletteUsage._blocksW && _paletteUsage.uses(bx, by, colors));
+			SDL_Rect r;
+			r.x = bx1 * PaletteUsage::kBlockSize;
+			r.y = by * PaletteUsage::kBlockSize;
+			r.w = MIN(bx * PaletteUsage::kBlockSize, _screenW) - r.x;
+			r.h = MIN(r.y + PaletteUsage::kBlockSize, _screenH) - r.y;
+			if (bounds) {
+				extendBounds(bounds, &r);
+			} else {
+				expandPixels(&r, buf, palette, dbgMask);
+			}
 		}
-		_fadeOnUpdateScreen = false;
-		SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_NONE);
+	}
+}
+
+void SystemStub_SDL::fadeScreen() {
+	_fadeOnUpdateScreen = true;
+}
+
+void SystemStub_SDL::updateScreen(int shakeOffset) {
+	const uint64_t now = getTimeNs();
+	if ((g_debugMask & DBG_AUDIO) != 0 && now - _audioStatsLogTimestamp >= kAudioStatsLogInterval) {
+		if (_audioStatsLogTimestamp != 0) {
+			AudioStats stats;
+			getAudioStats(&stats);
+			logAudioStats(&stats);
+		}
+		_audioStatsLogTimestamp = now;
+	}
+	_perf.dirtyRects = _dirtyRects;
+	_perf.dirtyArea = _dirtyArea;
+	_dirtyRects = _dirtyArea = 0;
+	if (_capture) {
+		captureScreen();
+	}
+	if (_gameThreaded) {
+		publishFrame(shakeOffset);
 		return;
 	}
-	if (shakeOffset != 0) {
+	updateTexture(_indexedScreen, _rgbPalette, _blitRects, _numBlitRects, _pi.dbgMask);
+	presentScreen(shakeOffset, _fadeOnUpdateScreen, (_pi.dbgMask & PlayerInput::DF_PERFHUD) != 0, &_perf);
+	_fadeOnUpdateScreen = false;
+	_numBlitRects = 0;
+}
+
+void SystemStub_SDL::publishFrame(int shakeOffset) {
+	PresentFrame *frame = &_frames[_backFrame];
+	memcpy(frame->pixels, _indexedScreen, _screenW * _screenH);
+	memcpy(frame->palette, _rgbPalette, sizeof(_rgbPalette));
+	memcpy(frame->rects, _blitRects, _numBlitRects * sizeof(SDL_Rect));
+	frame->rectsCount = _numBlitRects;
+	frame->shakeOffset = shakeOffset;
+	frame->fade = _fadeOnUpdateScreen;
+	frame->dbgMask = _pi.dbgMask;
+	frame->perf = _perf;
+	_fadeOnUpdateScreen = false;
+	_numBlitRects = 0;
+	SDL_LockMutex(_mailboxMutex);
+	if (_framePending) {
+		// the previous frame was not presented, its rectangles are expanded with this one
+		const PresentFrame *prev = &_frames[_pendingFrame];
+		if (frame->rectsCount + prev->rectsCount > PresentFrame::kRectsCount) {
+			frame->rects[0].x = frame->rects[0].y = 0;
+			frame->rects[0].w = _screenW;
+			frame->rects[0].h = _screenH;
+			frame->rectsCount = 1;
+		} else {
+			memcpy(frame->rects + frame->rectsCount, prev->rects, prev->rectsCount * sizeof(SDL_Rect));
+			frame->rectsCount += prev->rectsCount;
+		}
+		frame->fade |= prev->fade;
+	}
+	SWAP(_backFrame, _pendingFrame);
+	_framePending = true;
+	SDL_CondSignal(_mailboxCond);
+	SDL_UnlockMutex(_mailboxMutex);
+}
+
+void SystemStub_SDL::presentFrame(const PresentFrame *frame) {
+	updateTexture(frame->pixels, frame->palette, frame->rects, frame->rectsCount, frame->dbgMask);
+	presentScreen(frame->shakeOffset, frame->fade, (frame->dbgMask & PlayerInput::DF_PERFHUD) != 0, &frame->perf);
+}
+
+void SystemStub_SDL::redrawPresentedFrame() {
+	// the new texture is filled again with the last presented frame
+	PresentFrame *frame = &_frames[_frontFrame];
+	frame->rects[0].x = frame->rects[0].y = 0;
+	frame->rects[0].w = _screenW;
+	frame->rects[0].h = _screenH;
+	frame->rectsCount = 1;
+	frame->fade = false;
+	presentFrame(frame);
+}
+
+void SystemStub_SDL::runLoop(void (*proc)(void *param), void *param) {
+	if (!_presentThread) {
+		proc(param);
+		return;
+	}
+	_gameProc = proc;
+	_gameParam = param;
+	_backFrame = 0;
+	_pendingFrame = 1;
+	_frontFrame = 2;
+	_framePending = false;
+	_gameDone = false;
+	_eventsHead = _eventsCount = 0;
+	_screenSizeRequestW = _screenSizeRequestH = 0;
+	_gameThreaded = true;
+	_gameThread = SDL_CreateThread(gameThread, "Game", this);
+	if (!_gameThread) {
+		warning("SystemStub_SDL::runLoop() Unable to create thread");
+		_gameThreaded = false;
+		proc(param);
+		return;
+	}
+	presentationLoop();
+	SDL_WaitThread(_gameThread, 0);
+	_gameThread = 0;
+	_gameThreaded = false;
+}
+
+int SystemStub_SDL::gameThread(void *param) {
+	SystemStub_SDL *stub = (SystemStub_SDL *)param;
+	stub->_gameProc(stub->_gameParam);
+	SDL_LockMutex(stub->_mailboxMutex);
+	stub->_gameDone = true;
+	SDL_CondBroadcast(stub->_mailboxCond);
+	SDL_UnlockMutex(stub->_mailboxMutex);
+	return 0;
+}
+
+void SystemStub_SDL::presentationLoop() {
+	// the SDL renderer is not thread safe on all platforms, the window, the renderer and the events stay on the main thread
+	while (1) {
+		SDL_Event ev;
+		while (SDL_PollEvent(&ev)) {
+			if (!processWindowEvent(ev)) {
+				queueEvent(ev);
+			}
+		}
+		SDL_LockMutex(_mailboxMutex);
+		if (!_framePending && !_gameDone && _screenSizeRequestW == 0) {
+			// the events are polled again after the delay, the fade goes on with the last frame
+			SDL_CondWaitTimeout(_mailboxCond, _mailboxMutex, _fadeActive ? kFadeStepDelay : kEventsPollDelay);
+		}
+		if (_gameDone) {
+			SDL_UnlockMutex(_mailboxMutex);
+			break;
+		}
+		if (_screenSizeRequestW != 0) {
+			// a frame left pending has the previous size
+			resizeScreen(_screenSizeRequestW, _screenSizeRequestH);
+			_framePending = false;
+			_screenSizeRequestW = _screenSizeRequestH = 0;
+			SDL_CondBroadcast(_mailboxCond);
+			SDL_UnlockMutex(_mailboxMutex);
+			continue;
+		}
+		if (!_framePending) {
+			SDL_UnlockMutex(_mailboxMutex);
+			if (_fadeActive && getTimeNs() - _renderTime >= kFadeStepDelay * 1000000ULL) {
+				renderScreen(&_frames[_frontFrame].perf);
+			}
+			continue;
+		}
+		SWAP(_frontFrame, _pendingFrame);
+		_framePending = false;
+		SDL_UnlockMutex(_mailboxMutex);
+		presentFrame(&_frames[_frontFrame]);
+	}
+}
+
+void SystemStub_SDL::presentScreen(int shakeOffset, bool fade, bool perfHud, const PerfStats *perf) {
+	const uint64_t now = getTimeNs();
+	_hud.addFrame(now);
+	if (fade) {
+		// the screen is faded in from black over the next presented frames
+		_fadeActive = true;
+		_fadeStartTime = now;
+	}
+	_presentedShakeOffset = shakeOffset;
+	_presentedPerfHud = perfHud;
+	renderScreen(perf);
+}
+
+void SystemStub_SDL::renderScreen(const PerfStats *perf) {
+	_renderTime = getTimeNs();
+	SDL_RenderClear(_renderer);
+	if (_presentedShakeOffset != 0) {
 		SDL_Rect r;
 		r.x = 0;
-		r.y = shakeOffset * _scaleFactor;
+		r.y = _presentedShakeOffset * _scaleFactor;
 		SDL_GetRendererOutputSize(_renderer, &r.w, &r.h);
 		r.h -= r.y;
 		SDL_RenderCopy(_renderer, _texture, 0, &r);
 	} else {
 		SDL_RenderCopy(_renderer, _texture, 0, 0);
 	}
+	if (_fadeActive) {
+		const uint64_t elapsed = _renderTime - _fadeStartTime;
+		if (elapsed >= kFadeDuration) {
+			_fadeActive = false;
+		} else {
+			SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_BLEND);
+			SDL_SetRenderDrawColor(_renderer, 0, 0, 0, 255 - elapsed * 255 / kFadeDuration);
+			SDL_Rect r;
+			r.x = r.y = 0;
+			SDL_GetRendererOutputSize(_renderer, &r.w, &r.h);
+			SDL_RenderFillRect(_renderer, &r);
+			SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_NONE);
+		}
+	}
+	if (_presentedPerfHud) {
+		drawPerfHud(perf);
+	}
 	SDL_RenderPresent(_renderer);
-	_numBlitRects = 0;
 }
 
 void SystemStub_SDL::processEvents() {
+	if (_fadeActive && !_gameThreaded && getTimeNs() - _renderTime >= kFadeStepDelay * 1000000ULL) {
+		// the fade goes on when the screen is not updated
+		renderScreen(&_perf);
+	}
 	bool paused = false;
 	while (true) {
 		SDL_Event ev;
-		while (SDL_PollEvent(&ev)) {
+		while (nextEvent(&ev)) {
 			processEvent(ev, paused);
 			if (_pi.quit) {
 				return;
@@ -275,6 +775,68 @@ void SystemStub_SDL::processEvents() {
 	}
 }
 
+bool SystemStub_SDL::nextEvent(SDL_Event *ev) {
+	if (!_gameThreaded) {
+		while (SDL_PollEvent(ev)) {
+			if (!processWindowEvent(*ev)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	// polled by the main thread
+	SDL_LockMutex(_mailboxMutex);
+	const bool pending = (_eventsCount != 0);
+	if (pending) {
+		*ev = _events[_eventsHead];
+		_eventsHead = (_eventsHead + 1) % kEventsQueueSize;
+		--_eventsCount;
+	}
+	SDL_UnlockMutex(_mailboxMutex);
+	return pending;
+}
+
+void SystemStub_SDL::queueEvent(const SDL_Event &ev) {
+	SDL_LockMutex(_mailboxMutex);
+	if (_eventsCount < kEventsQueueSize) {
+		_events[(_eventsHead + _eventsCount) % kEventsQueueSize] = ev;
+		++_eventsCount;
+	} else {
+		warning("SystemStub_SDL::queueEvent() Events queue is full, dropping event type 0x%x", ev.type);
+	}
+	SDL_UnlockMutex(_mailboxMutex);
+}
+
+bool SystemStub_SDL::processWindowEvent(const SDL_Event &ev) {
+	// window changes and screenshots, handled on the thread owning the renderer
+	if (ev.type != SDL_KEYUP || !(ev.key.keysym.mod & KMOD_ALT)) {
+		return false;
+	}
+	switch (ev.key.keysym.sym) {
+	case SDLK_RETURN:
+		changeGraphics(!_fullscreen, _scaleFactor);
+		break;
+	case SDLK_KP_PLUS:
+	case SDLK_PAGEUP:
+		changeGraphics(_fullscreen, _scaleFactor + 1);
+		break;
+	case SDLK_KP_MINUS:
+	case SDLK_PAGEDOWN:
+		changeGraphics(_fullscreen, _scaleFactor - 1);
+		break;
+	case SDLK_s: {
+			const int type = ((ev.key.keysym.mod & KMOD_SHIFT) && _texW != _screenW) ? 2 : 1;
+			// the last presented frame when the game runs on its own thread
+			queueScreenshot(type, _screenshot, _gameThreaded ? _frames[_frontFrame].pixels : _indexedScreen);
+			++_screenshot;
+		}
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
 void SystemStub_SDL::processEvent(const SDL_Event &ev, bool &paused) {
 	switch (ev.type) {
 	case SDL_QUIT:
@@ -435,25 +997,6 @@ void SystemStub_SDL::processEvent(const SDL_Event &ev, bool &paused) {
 	case SDL_KEYUP:
 		if (ev.key.keysym.mod & KMOD_ALT) {
 			switch (ev.key.keysym.sym) {
-			case SDLK_RETURN:
-				changeGraphics(!_fullscreen, _scaleFactor);
-				break;
-			case SDLK_KP_PLUS:
-			case SDLK_PAGEUP:
-				changeGraphics(_fullscreen, _scaleFactor + 1);
-				break;
-			case SDLK_KP_MINUS:
-			case SDLK_PAGEDOWN:
-				changeGraphics(_fullscreen, _scaleFactor - 1);
-				break;
-			case SDLK_s: {
-					char name[32];
-					snprintf(name, sizeof(name), "screenshot-%03d.tga", _screenshot);
-					saveTGA(name, (const uint8_t *)_screenBuffer, _screenW, _screenH);
-					++_screenshot;
-					debug(DBG_INFO, "Written '%s'", name);
-				}
-				break;
 			case SDLK_x:
 				_pi.quit = true;
 				break;
@@ -470,6 +1013,9 @@ void SystemStub_SDL::processEvent(const SDL_Event &ev, bool &paused) {
 			case SDLK_i:
 				_pi.dbgMask ^= PlayerInput::DF_SETLIFE;
 				break;
+			case SDLK_p:
+				_pi.dbgMask ^= PlayerInput::DF_PERFHUD;
+				break;
 			case SDLK_s:
 				_pi.save = true;
 				break;
@@ -514,6 +1060,9 @@ void SystemStub_SDL::processEvent(const SDL_Event &ev, bool &paused) {
 		case SDLK_ESCAPE:
 			_pi.escape = false;
 			break;
+		case SDLK_r:
+			_pi.rewind = false;
+			break;
 		default:
 			break;
 		}
@@ -552,6 +1101,9 @@ void SystemStub_SDL::processEvent(const SDL_Event &ev, bool &paused) {
 		case SDLK_ESCAPE:
 			_pi.escape = true;
 			break;
+		case SDLK_r:
+			_pi.rewind = true;
+			break;
 		default:
 			break;
 		}
@@ -565,14 +1117,31 @@ void SystemStub_SDL::sleep(int duration) {
 	SDL_Delay(duration);
 }
 
+void SystemStub_SDL::sleepUntil(uint64_t timestamp) {
+	// SDL_Delay can wake up a few milliseconds late, spin for the end of the wait
+	const uint64_t now = getTimeNs();
+	if (timestamp > now + kSleepSpinDuration) {
+		SDL_Delay((timestamp - now - kSleepSpinDuration) / 1000000);
+	}
+	while (getTimeNs() < timestamp) {
+	}
+}
+
 uint32_t SystemStub_SDL::getTimeStamp() {
 	return SDL_GetTicks();
 }
 
 static void mixAudioS16(void *param, uint8_t *buf, int len) {
 	SystemStub_SDL *stub = (SystemStub_SDL *)param;
+	const uint64_t t = getTimeNs();
 	memset(buf, 0, len);
 	stub->_audioCbProc(stub->_audioCbData, (int16_t *)buf, len / 2);
+	const uint32_t duration = (getTimeNs() - t) / 1000;
+	const uint32_t period = (uint64_t)(len / 2) * 1000000 / kAudioHz;
+	stub->_perf.audioLoad = duration * 100 / period;
+	if (stub->_audioTelemetry.addCallback(t, duration, period)) {
+		++stub->_perf.audioUnderruns;
+	}
 }
 
 void SystemStub_SDL::startAudio(AudioCallback callback, void *param) {
@@ -584,6 +1153,7 @@ void SystemStub_SDL::startAudio(AudioCallback callback, void *param) {
 	desired.samples = 2048;
 	desired.callback = mixAudioS16;
 	desired.userdata = this;
+	_audioTelemetry.reset();
 	if (SDL_OpenAudio(&desired, &obtained) == 0) {
 		_audioCbProc = callback;
 		_audioCbData = param;
@@ -594,6 +1164,11 @@ void SystemStub_SDL::startAudio(AudioCallback callback, void *param) {
 }
 
 void SystemStub_SDL::stopAudio() {
+	if (g_debugMask & DBG_AUDIO) {
+		AudioStats stats;
+		getAudioStats(&stats);
+		logAudioStats(&stats);
+	}
 	SDL_CloseAudio();
 }
 
@@ -609,23 +1184,48 @@ void SystemStub_SDL::unlockAudio() {
 	SDL_UnlockAudio();
 }
 
+void SystemStub_SDL::getAudioStats(AudioStats *stats) {
+	const uint64_t now = getTimeNs();
+	LockAudioStack las(this);
+	_audioTelemetry.getStats(now, stats);
+}
+
+void SystemStub_SDL::queueScreenshot(int type, int num, const uint8_t *pixels) {
+	if (_directTexture) {
+		// the screen buffer is only filled for the screenshots
+		const int count = _screenW * _screenH;
+		for (int i = 0; i < count; ++i) {
+			_screenBuffer[i] = _presentedPalette[pixels[i]];
+		}
+	}
+	if (type == 2) {
+		// same scaler as the window texture
+		_screenshotWriter.queue("screenshot", num, _screenBuffer, _screenW, _screenH, _scaler, _scaleFactor);
+	} else {
+		_screenshotWriter.queue("screenshot", num, _screenBuffer, _screenW, _screenH);
+	}
+}
+
+void SystemStub_SDL::captureScreen() {
+	// the larger screens (Amiga title) are cropped to the recording size
+	if (_screenW >= _capture->_w && _screenH >= _capture->_h) {
+		Color palette[256];
+		for (int i = 0; i < 256; ++i) {
+			getPaletteEntry(i, &palette[i]);
+		}
+		const int offset = (_screenH - _capture->_h) / 2 * _screenW + (_screenW - _capture->_w) / 2;
+		_capture->pushFrame(_indexedScreen + offset, _screenW, palette, getTimeStamp());
+	}
+}
+
 void SystemStub_SDL::prepareGraphics() {
 	_texW = _screenW;
 	_texH = _screenH;
-	switch (_scalerType) {
-	case kScalerTypePoint:
-		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0"); // nearest pixel sampling
-		break;
-	case kScalerTypeLinear:
-		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
-		break;
-	case kScalerTypeInternal:
-	case kScalerTypeExternal:
-		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
+	if (_scalerType == kScalerTypeInternal || _scalerType == kScalerTypeExternal) {
 		_texW *= _scaleFactor;
 		_texH *= _scaleFactor;
-		break;
 	}
+	_directTexture = (_texW == _screenW && _texH == _screenH);
 	const int windowW = _screenW * _scaleFactor;
 	const int windowH = _screenH * _scaleFactor;
 	int flags = 0;
@@ -638,51 +1238,82 @@ void SystemStub_SDL::prepareGraphics() {
 		SDL_SetWindowIcon(_window, icon);
 		SDL_FreeSurface(icon);
 	}
+	createRenderer();
+}
+
+void SystemStub_SDL::createRenderer() {
+	switch (_scalerType) {
+	case kScalerTypePoint:
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0"); // nearest pixel sampling
+		break;
+	case kScalerTypeLinear:
+	case kScalerTypeInternal:
+	case kScalerTypeExternal:
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
+		break;
+	}
 	_renderer = SDL_CreateRenderer(_window, -1, SDL_RENDERER_ACCELERATED);
-	SDL_RenderSetLogicalSize(_renderer, windowW, windowH);
+	SDL_RenderSetLogicalSize(_renderer, _screenW * _scaleFactor, _screenH * _scaleFactor);
 	_texture = SDL_CreateTexture(_renderer, kPixelFormat, SDL_TEXTUREACCESS_STREAMING, _texW, _texH);
-	_fmt = SDL_AllocFormat(kPixelFormat);
-	forceGraphicsRedraw();
+	_hudTexture = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, PerfHud::kW, PerfHud::kH);
+	SDL_SetTextureBlendMode(_hudTexture, SDL_BLENDMODE_BLEND);
+}
+
+void SystemStub_SDL::destroyRenderer() {
+	if (_renderer) {
+		SDL_DestroyRenderer(_renderer);
+		_renderer = 0;
+	}
 }
 
 void SystemStub_SDL::cleanupGraphics() {
+	destroyRenderer();
+	freeScalerBuffer(&_scalerBuffer);
 	if (_screenBuffer) {
 		free(_screenBuffer);
 		_screenBuffer = 0;
 	}
+	free(_indexedScreen);
+	_indexedScreen = 0;
+	_paletteUsage.fini();
+	for (int i = 0; i < 3; ++i) {
+		free(_frames[i].pixels);
+		_frames[i].pixels = 0;
+	}
 	if (_window) {
 		SDL_DestroyWindow(_window);
 		_window = 0;
 	}
-	if (_renderer) {
-		SDL_DestroyRenderer(_renderer);
-		_renderer = 0;
-	}
-	if (_fmt) {
-		SDL_FreeFormat(_fmt);
-		_fmt = 0;
-	}
 }
 
 void SystemStub_SDL::changeGraphics(bool fullscreen, int scaleFactor) {
+	destroyRenderer();
 	if (_window) {
 		SDL_DestroyWindow(_window);
 		_window = 0;
 	}
-	if (_renderer) {
-		SDL_DestroyRenderer(_renderer);
-		_renderer = 0;
-	}
-	if (_fmt) {
-		SDL_FreeFormat(_fmt);
-		_fmt = 0;
-	}
 	_fullscreen = fullscreen;
 	if (scaleFactor >= _scaler->factorMin && scaleFactor <= _scaler->factorMax) {
 		_scaleFactor = scaleFactor;
 	}
 	prepareGraphics();
-	forceGraphicsRedraw();
+	if (_gameThreaded) {
+		// the blit rectangles belong to the game thread
+		redrawPresentedFrame();
+	} else {
+		forceGraphicsRedraw();
+	}
+}
+
+void SystemStub_SDL::drawPerfHud(const PerfStats *perf) {
+	// blended over the scaled screen, the game screen buffer is left untouched
+	_hud.draw(perf);
+	SDL_UpdateTexture(_hudTexture, 0, _hud._buffer, PerfHud::kW * sizeof(uint32_t));
+	SDL_Rect r;
+	r.x = r.y = 0;
+	r.w = PerfHud::kW * _scaleFactor;
+	r.h = PerfHud::kH * _scaleFactor;
+	SDL_RenderCopy(_renderer, _hudTexture, 0, &r);
 }
 
 void SystemStub_SDL::forceGraphicsRedraw() {
@@ -692,17 +1323,3 @@ void SystemStub_SDL::forceGraphicsRedraw() {
 	_blitRects[0].w = _screenW;
 	_blitRects[0].h = _screenH;
 }
-
-void SystemStub_SDL::drawRect(SDL_Rect *rect, uint8_t color) {
-	int x1 = rect->x;
-	int y1 = rect->y;
-	int x2 = rect->x + rect->w - 1;
-	int y2 = rect->y + rect->h - 1;
-	assert(x1 >= 0 && x2 < _screenW && y1 >= 0 && y2 < _screenH);
-	for (int i = x1; i <= x2; ++i) {
-		*(_screenBuffer + y1 * _screenW + i) = *(_screenBuffer + y2 * _screenW + i) = _rgbPalette[color];
-	}
-	for (int j = y1; j <= y2; ++j) {
-		*(_screenBuffer + j * _screenW + x1) = *(_screenBuffer + j * _screenW + x2) = _rgbPalette[color];
-	}
-}
@@ -13,24 +13,20 @@
 #include <android/log.h>
 #endif
 #include <stdarg.h>
+#ifndef _WIN32
+#include <time.h>
+#endif
+#include "log.h"
 #include "util.h"
 
 
 uint16_t g_debugMask;
 
-void debug(uint16_t cm, const char *msg, ...) {
-	char buf[1024];
-	if (cm & g_debugMask) {
-		va_list va;
-		va_start(va, msg);
-		vsprintf(buf, msg, va);
-		va_end(va);
-		fprintf(stdout, "%s\n", buf);
-		fflush(stdout);
-#ifdef __ANDROID__
-		__android_log_print(ANDROID_LOG_INFO, LOG_TAG, "%s", buf);
-#endif
-	}
+void logDebug(const char *msg, ...) {
+	va_list va;
+	va_start(va, msg);
+	writeLog(kLogDebug, msg, va);
+	va_end(va);
 }
 
 void error(const char *msg, ...) {
@@ -39,6 +35,7 @@ void error(const char *msg, ...) {
 	va_start(va, msg);
 	vsnprintf(buf, sizeof(buf), msg, va);
 	va_end(va);
+	flushLog();
 	fprintf(stderr, "ERROR: %s!\n", buf);
 #ifdef _WIN32
 	MessageBox(0, buf, g_caption, MB_ICONERROR);
@@ -50,14 +47,96 @@ void error(const char *msg, ...) {
 }
 
 void warning(const char *msg, ...) {
-	char buf[1024];
 	va_list va;
 	va_start(va, msg);
-	vsnprintf(buf, sizeof(buf), msg, va);
+	writeLog(kLogWarning, msg, va);
 	va_end(va);
-	fprintf(stderr, "WARNING: %s!\n", buf);
-#ifdef __ANDROID__
-	__android_log_print(ANDROID_LOG_WARN, LOG_TAG, "%s", buf);
+}
+
+
+uint64_t getTimeNs() {
+#ifdef _WIN32
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency(&freq);
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)(counter.QuadPart / freq.QuadPart) * 1000000000 + (uint64_t)(counter.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
 #endif
 }
 
+// xxHash64, https://github.com/Cyan4973/xxHash
+
+static const uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t readLE64(const uint8_t *p) {
+	return (uint64_t)READ_LE_UINT32(p) | ((uint64_t)READ_LE_UINT32(p + 4) << 32);
+}
+
+static inline uint64_t xxh64Round(uint64_t acc, uint64_t input) {
+	acc += input * kPrime64_2;
+	acc = rotl64(acc, 31);
+	return acc * kPrime64_1;
+}
+
+static inline uint64_t xxh64MergeRound(uint64_t acc, uint64_t val) {
+	acc ^= xxh64Round(0, val);
+	return acc * kPrime64_1 + kPrime64_4;
+}
+
+uint64_t hashXXH64(const void *data, uint32_t len, uint64_t seed) {
+	const uint8_t *p = (const uint8_t *)data;
+	const uint8_t *end = p + len;
+	uint64_t h;
+	if (len >= 32) {
+		uint64_t v1 = seed + kPrime64_1 + kPrime64_2;
+		uint64_t v2 = seed + kPrime64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - kPrime64_1;
+		do {
+			v1 = xxh64Round(v1, readLE64(p));
+			v2 = xxh64Round(v2, readLE64(p + 8));
+			v3 = xxh64Round(v3, readLE64(p + 16));
+			v4 = xxh64Round(v4, readLE64(p + 24));
+			p += 32;
+		} while (p + 32 <= end);
+		h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+		h = xxh64MergeRound(h, v1);
+		h = xxh64MergeRound(h, v2);
+		h = xxh64MergeRound(h, v3);
+		h = xxh64MergeRound(h, v4);
+	} else {
+		h = seed + kPrime64_5;
+	}
+	h += len;
+	for (; p + 8 <= end; p += 8) {
+		h ^= xxh64Round(0, readLE64(p));
+		h = rotl64(h, 27) * kPrime64_1 + kPrime64_4;
+	}
+	if (p + 4 <= end) {
+		h ^= (uint64_t)READ_LE_UINT32(p) * kPrime64_1;
+		h = rotl64(h, 23) * kPrime64_2 + kPrime64_3;
+		p += 4;
+	}
+	for (; p < end; ++p) {
+		h ^= *p * kPrime64_5;
+		h = rotl64(h, 11) * kPrime64_1;
+	}
+	h ^= h >> 33;
+	h *= kPrime64_2;
+	h ^= h >> 29;
+	h *= kPrime64_3;
+	h ^= h >> 32;
+	return h;
+}
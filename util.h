@@ -22,13 +22,20 @@ enum {
 	DBG_CUT    = 1 << 9,
 	DBG_MOD    = 1 << 10,
 	DBG_SFX    = 1 << 11,
-	DBG_FILE   = 1 << 12
+	DBG_FILE   = 1 << 12,
+	DBG_AUDIO  = 1 << 13
 };
 
-extern uint16_t g_debugMask;
+extern uint16_t g_debugMask; // set once at startup, shared by all the Game instances
 
-extern void debug(uint16_t cm, const char *msg, ...); // __attribute__((__format__(__printf__, 2, 3)))
+// the category is checked at the call site, the arguments are not evaluated when it is disabled
+#define debug(cm, ...) do { if ((cm) & g_debugMask) logDebug(__VA_ARGS__); } while (0)
+
+extern void logDebug(const char *msg, ...);           // __attribute__((__format__(__printf__, 1, 2)))
 extern void error(const char *msg, ...);              // __attribute__((__format__(__printf__, 1, 2)))
 extern void warning(const char *msg, ...);            // __attribute__((__format__(__printf__, 1, 2)))
 
+extern uint64_t getTimeNs(); // monotonic clock, for measurements
+extern uint64_t hashXXH64(const void *data, uint32_t len, uint64_t seed);
+
 #endif // UTIL_H__
@@ -10,8 +10,8 @@
 #include "util.h"
 #include "video.h"
 
-Video::Video(Resource *res, SystemStub *stub)
-	: _res(res), _stub(stub) {
+Video::Video(Resource *res, SystemStub *stub, const Options *options)
+	: _res(res), _stub(stub), _options(options) {
 	_w = GAMESCREEN_W;
 	_h = GAMESCREEN_H;
 	_layerSize = _w * _h;
@@ -22,6 +22,7 @@ Video::Video(Resource *res, SystemStub *stub)
 	_screenBlocks = (uint8_t *)calloc(1, (_w / SCREENBLOCK_W) * (_h / SCREENBLOCK_H));
 	_fullRefresh = true;
 	_shakeOffset = 0;
+	_paletteFadeStep = 0;
 	_charFrontColor = 0;
 	_charTransparentColor = 0;
 	_charShadowColor = 0;
@@ -62,6 +63,10 @@ void Video::markBlockAsDirty(int16_t x, int16_t y, uint16_t w, uint16_t h) {
 void Video::updateScreen() {
 	debug(DBG_VIDEO, "Video::updateScreen()");
 //	_fullRefresh = true;
+	const bool fadeStep = isPaletteFading();
+	if (fadeStep) {
+		stepPaletteFade();
+	}
 	if (_fullRefresh) {
 		_stub->copyRect(0, 0, _w, _h, _frontLayer, 256);
 		_stub->updateScreen(_shakeOffset);
@@ -90,7 +95,8 @@ void Video::updateScreen() {
 			}
 			p += _w / SCREENBLOCK_W;
 		}
-		if (count != 0) {
+		if (count != 0 || fadeStep) {
+			// the stub expands again the pixels of the faded colors
 			_stub->updateScreen(_shakeOffset);
 		}
 	}
@@ -108,26 +114,45 @@ void Video::fullRefresh() {
 
 void Video::fadeOut() {
 	debug(DBG_VIDEO, "Video::fadeOut()");
-	if (g_options.fade_out_palette) {
-		fadeOutPalette();
+	if (_options->fade_out_palette) {
+		startPaletteFade();
+		waitPaletteFade();
 	} else {
 		_stub->fadeScreen();
 	}
 }
 
-void Video::fadeOutPalette() {
-	for (int step = 16; step >= 0; --step) {
-		for (int c = 0; c < 256; ++c) {
-			Color col;
-			_stub->getPaletteEntry(c, &col);
-			col.r = col.r * step >> 4;
-			col.g = col.g * step >> 4;
-			col.b = col.b * step >> 4;
-			_stub->setPaletteEntry(c, &col);
-		}
-		fullRefresh();
+void Video::startPaletteFade() {
+	// the palette is faded to black over the next frames, one step for each updateScreen
+	for (int c = 0; c < 256; ++c) {
+		Color col;
+		_stub->getPaletteEntry(c, &col);
+		_paletteFadeColors[c * 3] = col.r;
+		_paletteFadeColors[c * 3 + 1] = col.g;
+		_paletteFadeColors[c * 3 + 2] = col.b;
+	}
+	_paletteFadeStep = PALETTE_FADE_STEPS;
+}
+
+void Video::stepPaletteFade() {
+	--_paletteFadeStep;
+	uint8_t faded[256 * 3];
+	for (int i = 0; i < 256 * 3; ++i) {
+		faded[i] = _paletteFadeColors[i] * _paletteFadeStep / PALETTE_FADE_STEPS;
+	}
+	_stub->setPalette(faded, 256);
+}
+
+void Video::waitPaletteFade() {
+	// for the callers replacing the palette and the screen once it is black
+	while (isPaletteFading() && !_stub->_pi.quit) {
 		updateScreen();
-		_stub->sleep(50);
+		_stub->processEvents();
+		_stub->_scheduler.wait(1000000000 / PALETTE_FADE_HZ);
+	}
+	if (isPaletteFading()) {
+		_paletteFadeStep = 1;
+		stepPaletteFade();
 	}
 }
 
@@ -466,9 +491,7 @@ static void decodeSgd(uint8_t *dst, const uint8_t *src, const uint8_t *data, con
 	} while (--count >= 0);
 }
 
-static const uint8_t *AMIGA_mirrorTileY(const uint8_t *a2) {
-	static uint8_t buf[32];
-
+static const uint8_t *AMIGA_mirrorTileY(const uint8_t *a2, uint8_t *buf) {
         a2 += 24;
 	for (int j = 0; j < 4; ++j) {
 		for (int i = 0; i < 8; ++i) {
@@ -479,9 +502,7 @@ static const uint8_t *AMIGA_mirrorTileY(const uint8_t *a2) {
 	return buf;
 }
 
-static const uint8_t *AMIGA_mirrorTileX(const uint8_t *a2) {
-	static uint8_t buf[32];
-
+static const uint8_t *AMIGA_mirrorTileX(const uint8_t *a2, uint8_t *buf) {
 	for (int i = 0; i < 32; ++i) {
 		uint8_t mask = 0;
 		for (int bit = 0; bit < 8; ++bit) {
@@ -495,11 +516,12 @@ static const uint8_t *AMIGA_mirrorTileX(const uint8_t *a2) {
 }
 
 static void AMIGA_drawTile(uint8_t *dst, int pitch, const uint8_t *src, int pal, const bool xflip, const bool yflip, int colorKey) {
+	uint8_t mirrorY[32], mirrorX[32];
 	if (yflip) {
-		src = AMIGA_mirrorTileY(src);
+		src = AMIGA_mirrorTileY(src, mirrorY);
 	}
 	if (xflip) {
-		src = AMIGA_mirrorTileX(src);
+		src = AMIGA_mirrorTileX(src, mirrorX);
 	}
 	for (int y = 0; y < 8; ++y) {
 		for (int i = 0; i < 8; ++i) {
@@ -21,7 +21,9 @@ struct Video {
 		SCREENBLOCK_W = 8,
 		SCREENBLOCK_H = 8,
 		CHAR_W = 8,
-		CHAR_H = 8
+		CHAR_H = 8,
+		PALETTE_FADE_STEPS = 16,
+		PALETTE_FADE_HZ = 30 // waitPaletteFade
 	};
 
 	static const uint8_t _conradPal1[];
@@ -31,6 +33,7 @@ struct Video {
 
 	Resource *_res;
 	SystemStub *_stub;
+	const Options *_options;
 
 	int _w, _h;
 	int _layerSize;
@@ -46,16 +49,21 @@ struct Video {
 	uint8_t *_screenBlocks;
 	bool _fullRefresh;
 	uint8_t _shakeOffset;
+	int _paletteFadeStep; // 0 when no fade is in progress
+	uint8_t _paletteFadeColors[256 * 3];
 	drawCharFunc _drawChar;
 
-	Video(Resource *res, SystemStub *stub);
+	Video(Resource *res, SystemStub *stub, const Options *options);
 	~Video();
 
 	void markBlockAsDirty(int16_t x, int16_t y, uint16_t w, uint16_t h);
 	void updateScreen();
 	void fullRefresh();
 	void fadeOut();
-	void fadeOutPalette();
+	void startPaletteFade();
+	void stepPaletteFade();
+	void waitPaletteFade();
+	bool isPaletteFading() const { return _paletteFadeStep != 0; }
 	void setPaletteColorBE(int num, int offset);
 	void setPaletteSlotBE(int palSlot, int palNum);
 	void setPaletteSlotLE(int palSlot, const uint8_t *palData);